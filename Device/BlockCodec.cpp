@@ -0,0 +1,584 @@
+#include "framework.h"
+#include "BlockCodec.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCKCODEC_SSE2 1
+#include <emmintrin.h>
+#else
+#define BLOCKCODEC_SSE2 0
+#endif
+
+namespace {
+    // block rows per task when the encoder runs on a thread pool
+    constexpr uint32_t s_nBandRows = 8;
+
+    // BC7 interpolation weights, by index bits
+    const int WEIGHTS2[4] = { 0, 21, 43, 64 };
+    const int WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const int WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // 4x4 RGBA8 texels, one row of the block per 16 bytes
+    struct Block
+    {
+        alignas(16) uint8_t m_texels[16][4];
+    };
+
+    void loadBlock(const uint8_t* pSrc, uint32_t nWidth, uint32_t nHeight, uint32_t nSrcRowPitch, uint32_t uBlockX, uint32_t uBlockY, Block& block)
+    {
+        uint32_t x0 = uBlockX * 4, y0 = uBlockY * 4;
+        if (x0 + 4 <= nWidth && y0 + 4 <= nHeight)
+        {
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                memcpy(block.m_texels[y * 4], pSrc + size_t(y0 + y) * nSrcRowPitch + size_t(x0) * 4, 16);
+            }
+            return;
+        }
+        // edge blocks repeat the last row and column
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            uint32_t uRow = std::min(y0 + y, nHeight - 1);
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                uint32_t uCol = std::min(x0 + x, nWidth - 1);
+                memcpy(block.m_texels[y * 4 + x], pSrc + size_t(uRow) * nSrcRowPitch + size_t(uCol) * 4, 4);
+            }
+        }
+    }
+
+    // per-channel bounds of the texels
+    void getMinMax(const Block& block, int vMin[4], int vMax[4])
+    {
+#if BLOCKCODEC_SSE2
+        const __m128i* pRows = reinterpret_cast<const __m128i*>(block.m_texels);
+        __m128i mn = _mm_min_epu8(_mm_min_epu8(pRows[0], pRows[1]), _mm_min_epu8(pRows[2], pRows[3]));
+        __m128i mx = _mm_max_epu8(_mm_max_epu8(pRows[0], pRows[1]), _mm_max_epu8(pRows[2], pRows[3]));
+        // down to the 4 channels of one texel
+        mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+        mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+        mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+        mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+        uint32_t uMin = uint32_t(_mm_cvtsi128_si32(mn)), uMax = uint32_t(_mm_cvtsi128_si32(mx));
+        for (int c = 0; c < 4; ++c)
+        {
+            vMin[c] = int((uMin >> (8 * c)) & 0xff);
+            vMax[c] = int((uMax >> (8 * c)) & 0xff);
+        }
+#else
+        for (int c = 0; c < 4; ++c)
+        {
+            vMin[c] = 255;
+            vMax[c] = 0;
+        }
+        for (auto& texel : block.m_texels)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                vMin[c] = std::min(vMin[c], int(texel[c]));
+                vMax[c] = std::max(vMax[c], int(texel[c]));
+            }
+        }
+#endif
+    }
+
+    // dot products of (texel - vOrigin) with vAxis
+    void project(const Block& block, const int vOrigin[4], const int vAxis[4], int dots[16])
+    {
+#if BLOCKCODEC_SSE2
+        const __m128i* pRows = reinterpret_cast<const __m128i*>(block.m_texels);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i origin = _mm_setr_epi16(short(vOrigin[0]), short(vOrigin[1]), short(vOrigin[2]), short(vOrigin[3]),
+            short(vOrigin[0]), short(vOrigin[1]), short(vOrigin[2]), short(vOrigin[3]));
+        __m128i axis = _mm_setr_epi16(short(vAxis[0]), short(vAxis[1]), short(vAxis[2]), short(vAxis[3]),
+            short(vAxis[0]), short(vAxis[1]), short(vAxis[2]), short(vAxis[3]));
+        for (int uRow = 0; uRow < 4; ++uRow)
+        {
+            // two texels of 16-bit channels per register, (r*ar + g*ag, b*ab + a*aa) per texel after the madd
+            __m128i lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(pRows[uRow], zero), origin), axis);
+            __m128i hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(pRows[uRow], zero), origin), axis);
+            __m128 flo = _mm_castsi128_ps(lo), fhi = _mm_castsi128_ps(hi);
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(flo, fhi, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(flo, fhi, _MM_SHUFFLE(3, 1, 3, 1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dots + uRow * 4), _mm_add_epi32(even, odd));
+        }
+#else
+        for (int i = 0; i < 16; ++i)
+        {
+            dots[i] = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                dots[i] += (int(block.m_texels[i][c]) - vOrigin[c]) * vAxis[c];
+            }
+        }
+#endif
+    }
+
+    // the endpoints start as the corners of the bounding box. channels that fall while the channel with the widest
+    // range rises get their ends swapped, so that the diagonal follows the texels
+    void orientEndpoints(const Block& block, int nChannels, int vLo[4], int vHi[4])
+    {
+        int iRef = 0;
+        for (int c = 1; c < nChannels; ++c)
+        {
+            if (vHi[c] - vLo[c] > vHi[iRef] - vLo[iRef])
+                iRef = c;
+        }
+        for (int c = 0; c < nChannels; ++c)
+        {
+            if (c == iRef)
+                continue;
+            int nCov = 0;
+            for (auto& texel : block.m_texels)
+            {
+                nCov += (2 * texel[c] - vLo[c] - vHi[c]) * (2 * texel[iRef] - vLo[iRef] - vHi[iRef]);
+            }
+            if (nCov < 0)
+            {
+                std::swap(vLo[c], vHi[c]);
+            }
+        }
+    }
+
+    uint16_t to565(const int v[4])
+    {
+        return uint16_t((((v[0] * 31 + 127) / 255) << 11) | (((v[1] * 63 + 127) / 255) << 5) | ((v[2] * 31 + 127) / 255));
+    }
+
+    void from565(uint16_t uColor, int v[4])
+    {
+        int r = (uColor >> 11) & 31, g = (uColor >> 5) & 63, b = uColor & 31;
+        v[0] = (r << 3) | (r >> 2);
+        v[1] = (g << 2) | (g >> 4);
+        v[2] = (b << 3) | (b >> 2);
+        v[3] = 255;
+    }
+
+    // BC1 block, also the color half of BC3
+    void encodeColor(const Block& block, const int vMin[4], const int vMax[4], uint8_t* pOut)
+    {
+        int vLo[4] = { vMin[0], vMin[1], vMin[2], 0 }, vHi[4] = { vMax[0], vMax[1], vMax[2], 0 };
+        orientEndpoints(block, 3, vLo, vHi);
+        // texels rarely sit in the corners of their box - inset it by 1/16 to spend the palette on the inside
+        for (int c = 0; c < 3; ++c)
+        {
+            int nInset = (vHi[c] - vLo[c]) / 16;
+            vLo[c] += nInset;
+            vHi[c] -= nInset;
+        }
+        // c0 > c1 selects the 4 color palette
+        uint16_t c0 = to565(vHi), c1 = to565(vLo);
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+        }
+
+        uint32_t uIndices = 0;
+        if (c0 != c1)
+        {
+            int v0[4], v1[4];
+            from565(c0, v0);
+            from565(c1, v1);
+            int vAxis[4] = { v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2], 0 };
+            int nLen2 = vAxis[0] * vAxis[0] + vAxis[1] * vAxis[1] + vAxis[2] * vAxis[2];
+            int dots[16];
+            project(block, v0, vAxis, dots);
+            // the palette is c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1 - indices by thirds of the way from c0 to c1
+            static const uint32_t s_indexOfThird[4] = { 0, 2, 3, 1 };
+            for (int i = 0; i < 16; ++i)
+            {
+                int nThird = std::clamp((dots[i] * 6 + nLen2) / (2 * nLen2), 0, 3);
+                uIndices |= s_indexOfThird[nThird] << (2 * i);
+            }
+        }
+        pOut[0] = uint8_t(c0);
+        pOut[1] = uint8_t(c0 >> 8);
+        pOut[2] = uint8_t(c1);
+        pOut[3] = uint8_t(c1 >> 8);
+        for (int b = 0; b < 4; ++b)
+        {
+            pOut[4 + b] = uint8_t(uIndices >> (8 * b));
+        }
+    }
+
+    // alpha half of BC3
+    void encodeAlpha(const Block& block, int nMin, int nMax, uint8_t* pOut)
+    {
+        uint64_t uIndices = 0;
+        if (nMax > nMin)
+        {
+            // a0 > a1 selects a0, a1 and 6 steps in between: index (8 - k) is k sevenths of the way from a1 to a0
+            int nRange = nMax - nMin;
+            for (int i = 0; i < 16; ++i)
+            {
+                int nSeventh = ((block.m_texels[i][3] - nMin) * 14 + nRange) / (2 * nRange);
+                uint64_t uIndex = nSeventh == 7 ? 0 : nSeventh == 0 ? 1 : uint64_t(8 - nSeventh);
+                uIndices |= uIndex << (3 * i);
+            }
+        }
+        pOut[0] = uint8_t(nMax);
+        pOut[1] = uint8_t(nMin);
+        for (int b = 0; b < 6; ++b)
+        {
+            pOut[2 + b] = uint8_t(uIndices >> (8 * b));
+        }
+    }
+
+    class BitWriter
+    {
+    public:
+        void write(uint32_t uValue, uint32_t nBits)
+        {
+            for (uint32_t u = 0; u < nBits; ++u, ++m_nPos)
+            {
+                if ((uValue >> u) & 1)
+                    m_bits[m_nPos >> 6] |= 1ull << (m_nPos & 63);
+            }
+        }
+        void store(uint8_t* pOut) const
+        {
+            for (int b = 0; b < 16; ++b)
+            {
+                pOut[b] = uint8_t(m_bits[b >> 3] >> ((b & 7) * 8));
+            }
+        }
+
+    private:
+        uint64_t m_bits[2] = {};
+        uint32_t m_nPos = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t* pBits) : m_pBits(pBits) {}
+        uint32_t read(uint32_t nBits)
+        {
+            uint32_t uValue = 0;
+            for (uint32_t u = 0; u < nBits; ++u, ++m_nPos)
+            {
+                uValue |= uint32_t((m_pBits[m_nPos >> 3] >> (m_nPos & 7)) & 1) << u;
+            }
+            return uValue;
+        }
+
+    private:
+        const uint8_t* m_pBits;
+        uint32_t m_nPos = 0;
+    };
+
+    // 7 bits per channel plus a p-bit shared by the 4 channels of the endpoint
+    void quantizeBC7Endpoint(const int v[4], int vQuant[4], int& nPBit)
+    {
+        int nBestErr = INT_MAX;
+        for (int p = 0; p < 2; ++p)
+        {
+            int q[4], nErr = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                q[c] = std::clamp((v[c] - p + 1) >> 1, 0, 127);
+                int d = ((q[c] << 1) | p) - v[c];
+                nErr += d * d;
+            }
+            if (nErr < nBestErr)
+            {
+                nBestErr = nErr;
+                nPBit = p;
+                std::copy(q, q + 4, vQuant);
+            }
+        }
+    }
+
+    // mode 6: one subset, RGBA endpoints, 4-bit indices
+    void encodeBC7(const Block& block, const int vMin[4], const int vMax[4], uint8_t* pOut)
+    {
+        int vLo[4], vHi[4];
+        std::copy(vMin, vMin + 4, vLo);
+        std::copy(vMax, vMax + 4, vHi);
+        orientEndpoints(block, 4, vLo, vHi);
+
+        int q0[4], q1[4], p0 = 0, p1 = 0;
+        quantizeBC7Endpoint(vLo, q0, p0);
+        quantizeBC7Endpoint(vHi, q1, p1);
+        int v0[4], vAxis[4], nLen2 = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            v0[c] = (q0[c] << 1) | p0;
+            vAxis[c] = ((q1[c] << 1) | p1) - v0[c];
+            nLen2 += vAxis[c] * vAxis[c];
+        }
+
+        int indices[16] = {};
+        if (nLen2 > 0)
+        {
+            int dots[16];
+            project(block, v0, vAxis, dots);
+            for (int i = 0; i < 16; ++i)
+            {
+                int nWeight = std::clamp((dots[i] * 128 + nLen2) / (2 * nLen2), 0, 64);
+                int iBest = 0;
+                for (int iWeight = 1; iWeight < 16; ++iWeight)
+                {
+                    if (abs(WEIGHTS4[iWeight] - nWeight) < abs(WEIGHTS4[iBest] - nWeight))
+                        iBest = iWeight;
+                }
+                indices[i] = iBest;
+            }
+        }
+        // the index of the first texel is stored without its top bit - swap the endpoints if it is set
+        // (the weights are symmetric, so 15 - index is exact)
+        if (indices[0] >= 8)
+        {
+            std::swap(q0, q1);
+            std::swap(p0, p1);
+            for (int& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter bits;
+        bits.write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            bits.write(uint32_t(q0[c]), 7);
+            bits.write(uint32_t(q1[c]), 7);
+        }
+        bits.write(uint32_t(p0), 1);
+        bits.write(uint32_t(p1), 1);
+        for (int i = 0; i < 16; ++i)
+        {
+            bits.write(uint32_t(indices[i]), i == 0 ? 3 : 4);
+        }
+        bits.store(pOut);
+    }
+
+    void decodeColor(const uint8_t* pBlock, bool bAlways4Colors, uint8_t* pTexels)
+    {
+        uint16_t c0 = uint16_t(pBlock[0] | (pBlock[1] << 8)), c1 = uint16_t(pBlock[2] | (pBlock[3] << 8));
+        uint32_t uIndices = uint32_t(pBlock[4]) | (uint32_t(pBlock[5]) << 8) | (uint32_t(pBlock[6]) << 16) | (uint32_t(pBlock[7]) << 24);
+        int palette[4][4];
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            if (c0 > c1 || bAlways4Colors)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = (c0 > c1 || bAlways4Colors) ? 255 : 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            const int* pColor = palette[(uIndices >> (2 * i)) & 3];
+            for (int c = 0; c < 4; ++c)
+            {
+                pTexels[i * 4 + c] = uint8_t(pColor[c]);
+            }
+        }
+    }
+
+    void decodeAlpha(const uint8_t* pBlock, uint8_t* pTexels)
+    {
+        int a0 = pBlock[0], a1 = pBlock[1];
+        int palette[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int i = 2; i < 8; ++i)
+                palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+        else
+        {
+            for (int i = 2; i < 6; ++i)
+                palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        uint64_t uIndices = 0;
+        for (int b = 0; b < 6; ++b)
+        {
+            uIndices |= uint64_t(pBlock[2 + b]) << (8 * b);
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            pTexels[i * 4 + 3] = uint8_t(palette[(uIndices >> (3 * i)) & 7]);
+        }
+    }
+
+    int expandBits(int nValue, int nBits)
+    {
+        nValue <<= 8 - nBits;
+        return nValue | (nValue >> nBits);
+    }
+
+    int interpolateBC7(int e0, int e1, int nIndexBits, int iIndex)
+    {
+        const int* pWeights = nIndexBits == 2 ? WEIGHTS2 : nIndexBits == 3 ? WEIGHTS3 : WEIGHTS4;
+        int w = pWeights[iIndex];
+        return ((64 - w) * e0 + w * e1 + 32) >> 6;
+    }
+
+    void decodeBC7(const uint8_t* pBlock, uint8_t* pTexels)
+    {
+        BitReader bits(pBlock);
+        int iMode = 0;
+        while (iMode < 8 && bits.read(1) == 0)
+        {
+            ++iMode;
+        }
+        if (iMode < 4 || iMode > 6)
+        {
+            // mode 8 is reserved and decodes to zero by the spec
+            assert(iMode == 8 && "Multi-subset BC7 modes are not supported");
+            memset(pTexels, 0, 64);
+            return;
+        }
+
+        int nRotation = 0, nIndexSelection = 0;
+        if (iMode == 4)
+        {
+            nRotation = int(bits.read(2));
+            nIndexSelection = int(bits.read(1));
+        }
+        else if (iMode == 5)
+        {
+            nRotation = int(bits.read(2));
+        }
+        int nColorBits = iMode == 4 ? 5 : 7, nAlphaBits = iMode == 4 ? 6 : iMode == 5 ? 8 : 7;
+        int e[2][4];
+        for (int c = 0; c < 3; ++c)
+        {
+            e[0][c] = int(bits.read(nColorBits));
+            e[1][c] = int(bits.read(nColorBits));
+        }
+        e[0][3] = int(bits.read(nAlphaBits));
+        e[1][3] = int(bits.read(nAlphaBits));
+        if (iMode == 6)
+        {
+            int p0 = int(bits.read(1)), p1 = int(bits.read(1));
+            for (int c = 0; c < 4; ++c)
+            {
+                e[0][c] = (e[0][c] << 1) | p0;
+                e[1][c] = (e[1][c] << 1) | p1;
+            }
+        }
+        else
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                e[0][c] = expandBits(e[0][c], c < 3 ? nColorBits : nAlphaBits);
+                e[1][c] = expandBits(e[1][c], c < 3 ? nColorBits : nAlphaBits);
+            }
+        }
+
+        // the first index of every set is stored without its top bit
+        int sets[2][16] = {};
+        int nSetBits[2] = { iMode == 6 ? 4 : 2, iMode == 4 ? 3 : 2 };
+        int nSets = iMode == 6 ? 1 : 2;
+        for (int iSet = 0; iSet < nSets; ++iSet)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                sets[iSet][i] = int(bits.read(uint32_t(i == 0 ? nSetBits[iSet] - 1 : nSetBits[iSet])));
+            }
+        }
+        // mode 4 may use the 3-bit set for color, mode 6 uses one set for all channels
+        int iColorSet = (iMode == 4 && nIndexSelection) ? 1 : 0;
+        int iAlphaSet = iMode == 6 ? 0 : 1 - iColorSet;
+        for (int i = 0; i < 16; ++i)
+        {
+            uint8_t* pTexel = pTexels + i * 4;
+            for (int c = 0; c < 3; ++c)
+            {
+                pTexel[c] = uint8_t(interpolateBC7(e[0][c], e[1][c], nSetBits[iColorSet], sets[iColorSet][i]));
+            }
+            pTexel[3] = uint8_t(interpolateBC7(e[0][3], e[1][3], nSetBits[iAlphaSet], sets[iAlphaSet][i]));
+            if (nRotation > 0)
+            {
+                std::swap(pTexel[3], pTexel[nRotation - 1]);
+            }
+        }
+    }
+
+    void encodeBlockRows(IResource::eFormat format, const uint8_t* pSrc, uint32_t nWidth, uint32_t nHeight, uint32_t nSrcRowPitch,
+        uint8_t* pDst, uint32_t nDstRowPitch, uint32_t uFirstRow, uint32_t uEndRow)
+    {
+        uint32_t nBlocksX = (nWidth + 3) / 4;
+        uint32_t nBytesPerBlock = IResource::getBytesPerPixel(format);
+        Block block;
+        for (uint32_t uBlockY = uFirstRow; uBlockY < uEndRow; ++uBlockY)
+        {
+            uint8_t* pOut = pDst + size_t(uBlockY) * nDstRowPitch;
+            for (uint32_t uBlockX = 0; uBlockX < nBlocksX; ++uBlockX, pOut += nBytesPerBlock)
+            {
+                loadBlock(pSrc, nWidth, nHeight, nSrcRowPitch, uBlockX, uBlockY, block);
+                int vMin[4], vMax[4];
+                getMinMax(block, vMin, vMax);
+                switch (format)
+                {
+                case IResource::eFormatBC1:
+                    encodeColor(block, vMin, vMax, pOut);
+                    break;
+                case IResource::eFormatBC3:
+                    encodeAlpha(block, vMin[3], vMax[3], pOut);
+                    encodeColor(block, vMin, vMax, pOut + 8);
+                    break;
+                case IResource::eFormatBC7:
+                    encodeBC7(block, vMin, vMax, pOut);
+                    break;
+                default:
+                    assert(false && "Not a block-compressed format");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void BlockCodec::encode(IResource::eFormat format, const uint8_t* pSrc, uint32_t nWidth, uint32_t nHeight,
+    uint32_t nSrcRowPitch, uint8_t* pDst, uint32_t nDstRowPitch, ThreadPool* pThreadPool)
+{
+    assert(IResource::getBlockSize(format) == 4 && "Not a block-compressed format");
+    uint32_t nBlockRows = IResource::getBlockRows(format, nHeight);
+    uint32_t nBands = (nBlockRows + s_nBandRows - 1) / s_nBandRows;
+    if (!pThreadPool || pThreadPool->getNumThreads() < 2 || nBands < 2)
+    {
+        encodeBlockRows(format, pSrc, nWidth, nHeight, nSrcRowPitch, pDst, nDstRowPitch, 0, nBlockRows);
+        return;
+    }
+    pThreadPool->parallelFor(nBands, [&](uint32_t uBand)
+    {
+        encodeBlockRows(format, pSrc, nWidth, nHeight, nSrcRowPitch, pDst, nDstRowPitch,
+            uBand * s_nBandRows, std::min(nBlockRows, (uBand + 1) * s_nBandRows));
+    });
+}
+
+void BlockCodec::decodeBlock(IResource::eFormat format, const uint8_t* pBlock, uint8_t* pTexels)
+{
+    switch (format)
+    {
+    case IResource::eFormatBC1:
+        decodeColor(pBlock, false, pTexels);
+        break;
+    case IResource::eFormatBC3:
+        decodeColor(pBlock + 8, true, pTexels);
+        decodeAlpha(pBlock, pTexels);
+        break;
+    case IResource::eFormatBC7:
+        decodeBC7(pBlock, pTexels);
+        break;
+    default:
+        assert(false && "Not a block-compressed format");
+        break;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "IResource.h"
+#include <cstdint>
+
+class ThreadPool;
+
+// CPU encoder and decoder of the block-compressed formats (IResource::getBlockSize() > 1). images are split into
+// 4x4 blocks, the blocks at the right and bottom edge of images that are not a multiple of 4 repeat the last texels.
+// BC1 drops alpha, BC7 is encoded with mode 6 (one subset, RGBA endpoints) only
+struct BlockCodec
+{
+    // encodes an RGBA8 image into getBlockRows(nHeight) rows of blocks, nDstRowPitch bytes apart. with a thread pool,
+    // bands of block rows are spread over its threads (see ThreadPool::parallelFor(), this may be called from a
+    // task of the same pool)
+    static void encode(IResource::eFormat format, const uint8_t* pSrc, uint32_t nWidth, uint32_t nHeight,
+        uint32_t nSrcRowPitch, uint8_t* pDst, uint32_t nDstRowPitch, ThreadPool* pThreadPool = nullptr);
+
+    // decodes one block into 4x4 RGBA8 texels, rows of 16 bytes. BC7 blocks of the multi-subset modes are not
+    // supported and decode to zero
+    static void decodeBlock(IResource::eFormat format, const uint8_t* pBlock, uint8_t* pTexels);
+};
@@ -0,0 +1,178 @@
+#include "framework.h"
+#include "CpuCmdList.h"
+#include "CpuResource.h"
+#include "BlockCodec.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    std::shared_ptr<CpuResource> toCpuResource(IResource* pResource)
+    {
+        auto pCpuResource = dynamic_cast<CpuResource*>(pResource);
+        assert(pCpuResource && "Failed to cast to CPU resource");
+        return std::static_pointer_cast<CpuResource>(pCpuResource->shared_from_this());
+    }
+
+    // copy of a block-compressed texture into an RGBA8 one
+    bool isDecodingCopy(const CpuResource& dst, const CpuResource& src)
+    {
+        return IResource::getBlockSize(src.getFormat()) > 1 && dst.getFormat() == IResource::eFormatRGBA8;
+    }
+
+    // decodes the blocks of srcBox (covering whole blocks) into the RGBA8 texels at dstOffset
+    void decodeRegion(CpuResource& dst, const int3& dstOffset, CpuResource& src, const ibox3& srcBox)
+    {
+        uint8_t texels[16 * 4];
+        for (int z = srcBox.m_mins.z; z <= srcBox.m_maxs.z; ++z)
+        {
+            for (int y = srcBox.m_mins.y; y <= srcBox.m_maxs.y; y += 4)
+            {
+                for (int x = srcBox.m_mins.x; x <= srcBox.m_maxs.x; x += 4)
+                {
+                    BlockCodec::decodeBlock(src.getFormat(), src.getTexel(int3(x, y, z)), texels);
+                    int3 vDst = dstOffset + int3(x, y, z) - srcBox.m_mins;
+                    for (int uRow = 0; uRow < 4; ++uRow)
+                    {
+                        memcpy(dst.getTexel(vDst + int3(0, uRow, 0)), texels + uRow * 16, 16);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CpuCmdList::barriersImpl(std::span<const Barrier> barriers)
+{
+    // host memory has no layouts or caches to transition - commands already execute in order
+    for (auto& barrier : barriers)
+    {
+        assert(dynamic_cast<CpuResource*>(barrier.m_pResource) && "Failed to cast to CPU resource");
+        (void)barrier;
+    }
+}
+
+void CpuCmdList::copyImpl(IResource* pDst, IResource* pSrc)
+{
+    Cmd cmd;
+    cmd.m_eType = eCmdCopy;
+    cmd.m_pDst = toCpuResource(pDst);
+    cmd.m_pSrc = toCpuResource(pSrc);
+    assert((cmd.m_pDst->getSize() == cmd.m_pSrc->getSize() || isDecodingCopy(*cmd.m_pDst, *cmd.m_pSrc)) &&
+        "CopyResource requires identical resources");
+    m_cmds.push_back(std::move(cmd));
+}
+
+void CpuCmdList::copyFromStagingImpl(IResource* pDstTexture2D, const ibox2& dstRect, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow,
+    uint32_t uMip)
+{
+    Cmd cmd;
+    cmd.m_eType = eCmdCopyFromStaging;
+    cmd.m_pDst = toCpuResource(pDstTexture2D);
+    cmd.m_pSrc = toCpuResource(pSrcBuffer);
+    cmd.m_nSrcOffset = nSrcOffset;
+    cmd.m_nSrcBytesPerRow = nSrcBytesPerRow;
+    cmd.m_uMip = uMip;
+    cmd.m_srcBox = ibox3(int3(dstRect.m_mins, 0), int3(dstRect.m_maxs, 0));
+    int nBlockSize = int(IResource::getBlockSize(cmd.m_pDst->getFormat()));
+    uint64_t nRows = uint64_t(dstRect.m_maxs.y / nBlockSize - dstRect.m_mins.y / nBlockSize + 1);
+    assert(nSrcOffset + nRows * nSrcBytesPerRow <= cmd.m_pSrc->getSize() && "Copy source is out of bounds");
+    assert(cmd.m_pDst->contains(cmd.m_srcBox, uMip) && "Copy destination is out of bounds");
+    (void)nRows;
+    m_cmds.push_back(std::move(cmd));
+}
+
+void CpuCmdList::copyRegionImpl(IResource* pDst, const int3& dstOffset, IResource* pSrc, const ibox3& srcBox)
+{
+    Cmd cmd;
+    cmd.m_eType = eCmdCopyRegion;
+    cmd.m_pDst = toCpuResource(pDst);
+    cmd.m_pSrc = toCpuResource(pSrc);
+    cmd.m_srcBox = srcBox;
+    cmd.m_dstOffset = dstOffset;
+    assert(cmd.m_pSrc->contains(srcBox) && "Copy source is out of bounds");
+    assert(cmd.m_pDst->contains(srcBox.translate(dstOffset - srcBox.m_mins)) && "Copy destination is out of bounds");
+    assert((cmd.m_pDst->getFormat() == cmd.m_pSrc->getFormat() || isDecodingCopy(*cmd.m_pDst, *cmd.m_pSrc)) &&
+        "Copies between these formats are not supported");
+    m_cmds.push_back(std::move(cmd));
+}
+
+void CpuCmdList::writeTimestampImpl(uint32_t uSlot)
+{
+    assert(m_pTimestamps && "Command list has no timestamp storage");
+    Cmd cmd;
+    cmd.m_eType = eCmdTimestamp;
+    cmd.m_uSlot = uSlot;
+    m_cmds.push_back(std::move(cmd));
+}
+
+void CpuCmdList::run()
+{
+    for (auto& cmd : m_cmds)
+    {
+        switch (cmd.m_eType)
+        {
+        case eCmdCopy:
+            if (isDecodingCopy(*cmd.m_pDst, *cmd.m_pSrc))
+            {
+                IResource::ResDesc desc;
+                cmd.m_pSrc->getDesc(desc);
+                int3 vMaxs(int(desc.m_res[0]) - 1, int(desc.m_res[1]) - 1, desc.m_nDims == 3 ? int(desc.m_res[2]) - 1 : 0);
+                decodeRegion(*cmd.m_pDst, int3(0, 0, 0), *cmd.m_pSrc, ibox3(int3(0, 0, 0), vMaxs));
+                break;
+            }
+            memcpy(cmd.m_pDst->getData(), cmd.m_pSrc->getData(), cmd.m_pDst->getSize());
+            break;
+        case eCmdCopyFromStaging:
+        {
+            // rows of blocks for the block-compressed formats
+            int nBlockSize = int(IResource::getBlockSize(cmd.m_pDst->getFormat()));
+            uint32_t nDstRowPitch = cmd.m_pDst->getRowPitch(cmd.m_uMip);
+            uint32_t nRowBytes = uint32_t(cmd.m_srcBox.m_maxs.x / nBlockSize - cmd.m_srcBox.m_mins.x / nBlockSize + 1) * cmd.m_pDst->getTexelSize();
+            size_t nRows = size_t(cmd.m_srcBox.m_maxs.y / nBlockSize - cmd.m_srcBox.m_mins.y / nBlockSize + 1);
+            const uint8_t* pSrc = cmd.m_pSrc->getData() + cmd.m_nSrcOffset;
+            uint8_t* pDst = cmd.m_pDst->getTexel(int3(cmd.m_srcBox.m_mins.x, cmd.m_srcBox.m_mins.y, 0), cmd.m_uMip);
+            if (nDstRowPitch == cmd.m_nSrcBytesPerRow && nRowBytes == nDstRowPitch)
+            {
+                memcpy(pDst, pSrc, nRows * nDstRowPitch);
+                break;
+            }
+            for (size_t uRow = 0; uRow < nRows; ++uRow)
+            {
+                memcpy(pDst + uRow * nDstRowPitch, pSrc + uRow * cmd.m_nSrcBytesPerRow, nRowBytes);
+            }
+            break;
+        }
+        case eCmdCopyRegion:
+        {
+            const ibox3& box = cmd.m_srcBox;
+            if (isDecodingCopy(*cmd.m_pDst, *cmd.m_pSrc))
+            {
+                decodeRegion(*cmd.m_pDst, cmd.m_dstOffset, *cmd.m_pSrc, box);
+                break;
+            }
+            // one row of blocks at a time for the block-compressed formats
+            int nBlockSize = int(IResource::getBlockSize(cmd.m_pSrc->getFormat()));
+            uint32_t nRowBytes = uint32_t(box.m_maxs.x / nBlockSize - box.m_mins.x / nBlockSize + 1) * cmd.m_pSrc->getTexelSize();
+            for (int z = box.m_mins.z; z <= box.m_maxs.z; ++z)
+            {
+                for (int y = box.m_mins.y; y <= box.m_maxs.y; y += nBlockSize)
+                {
+                    int3 vDst = cmd.m_dstOffset + int3(0, y - box.m_mins.y, z - box.m_mins.z);
+                    memmove(cmd.m_pDst->getTexel(vDst), cmd.m_pSrc->getTexel(int3(box.m_mins.x, y, z)), nRowBytes);
+                }
+            }
+            break;
+        }
+        case eCmdTimestamp:
+            m_pTimestamps[cmd.m_uSlot] = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+            break;
+        default:
+            assert(false && "Unknown command");
+            break;
+        }
+    }
+    m_cmds.clear();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ICmdList.h"
+#include "IQueue.hpp"
+#include <vector>
+#include <memory>
+
+class CpuResource;
+
+// records commands on the calling thread, CpuQueue replays them on its worker thread
+class CpuCmdList : public ICmdList
+{
+public:
+    // executes all recorded commands - called on the queue thread
+    void run();
+
+    // pool bookkeeping of CpuQueue. reset() keeps the capacity of the command storage
+    void reset() { m_cmds.clear(); }
+    IQueue::RecordingPool* getPool() const { return m_pPool; }
+    void setPool(IQueue::RecordingPool* pPool) { m_pPool = pPool; }
+    uint64_t getFenceValue() const { return m_fenceValue; }
+    void setFenceValue(uint64_t fenceValue) { m_fenceValue = fenceValue; }
+    bool isRecording() const { return m_bRecording; }
+    void setRecording(bool bRecording) { m_bRecording = bRecording; }
+    // nanosecond timestamps of the queue's profiler
+    void setTimestamps(uint64_t* pTimestamps) { m_pTimestamps = pTimestamps; }
+
+protected:
+    // ICmdList interface
+    virtual void barriersImpl(std::span<const Barrier> barriers) override;
+    virtual void copyImpl(IResource* pDst, IResource* pSrc) override;
+    virtual void copyFromStagingImpl(IResource* pDstTexture2D, const ibox2& dstRect, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow,
+        uint32_t uMip) override;
+    virtual void copyRegionImpl(IResource* pDst, const int3& dstOffset, IResource* pSrc, const ibox3& srcBox) override;
+    virtual void writeTimestampImpl(uint32_t uSlot) override;
+
+private:
+    enum eCmd
+    {
+        eCmdCopy,
+        eCmdCopyFromStaging,
+        eCmdCopyRegion,
+        eCmdTimestamp
+    };
+    struct Cmd
+    {
+        eCmd m_eType;
+        // the list keeps resources alive until it has been executed
+        std::shared_ptr<CpuResource> m_pDst, m_pSrc;
+        uint64_t m_nSrcOffset = 0;
+        uint32_t m_nSrcBytesPerRow = 0;
+        // eCmdCopyFromStaging only
+        uint32_t m_uMip = 0;
+        // eCmdCopyFromStaging uses the xy part
+        ibox3 m_srcBox;
+        int3 m_dstOffset;
+        uint32_t m_uSlot = 0;
+    };
+    std::vector<Cmd> m_cmds;
+    IQueue::RecordingPool* m_pPool = nullptr;
+    uint64_t* m_pTimestamps = nullptr;
+    uint64_t m_fenceValue = 0;
+    bool m_bRecording = false;
+};
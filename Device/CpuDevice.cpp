@@ -0,0 +1,77 @@
+#include "framework.h"
+#include "CpuDevice.h"
+#include "CpuQueue.h"
+#include "CpuResource.h"
+#include "CpuFence.h"
+#include "HeadlessWindow.h"
+#include <cassert>
+
+std::shared_ptr<IDevice> IDevice::createCpuDevice()
+{
+    return std::make_shared<CpuDevice>();
+}
+
+CpuDevice::CpuDevice()
+{
+    m_sDesc = L"CPU";
+}
+
+CpuDevice::~CpuDevice()
+{
+    m_retireQueue.drain(RetireQueue::s_nDrainTimeoutMs);
+}
+
+std::shared_ptr<IWindow> CpuDevice::createWindow(uint32_t nSwapChainImages)
+{
+    // there is no display to present to - render into offscreen images
+    return HeadlessWindow::create(this, nSwapChainImages, uint2(1920, 1080));
+}
+
+std::shared_ptr<IQueue> CpuDevice::createQueue(const std::wstring &sName, eQueueType eType, uint32_t nAllocators)
+{
+    // every queue has its own worker thread, so queues of any type run independently of each other
+    return std::make_shared<CpuQueue>(this, sName, eType, nAllocators);
+}
+
+std::shared_ptr<IResource> CpuDevice::createResource(const IResource::ResDesc& desc)
+{
+    if (desc.m_nDims < 1 || desc.m_nDims > 3)
+    {
+        assert(false && "Unsupported number of dimensions");
+        return nullptr;
+    }
+    // same restriction as D3D12 - block-compressed textures are made of whole blocks
+    uint32_t nBlockSize = IResource::getBlockSize(desc.m_format);
+    assert((nBlockSize == 1 || (desc.m_res[0] % nBlockSize == 0 && desc.m_res[1] % nBlockSize == 0)) && "Texture size is not a multiple of the block size");
+    (void)nBlockSize;
+    assert((!desc.m_isPersistentlyMapped || desc.m_isStaging || desc.m_isReadback) && "Only staging and readback resources can be mapped");
+    return std::make_shared<CpuResource>(desc);
+}
+
+std::shared_ptr<IResource> CpuDevice::createSharedResource(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IResource> pResource)
+{
+    if (!std::dynamic_pointer_cast<CpuDevice>(pOtherDevice) || !std::dynamic_pointer_cast<CpuResource>(pResource))
+    {
+        assert(false && "Only CPU resources can be shared with a CPU device");
+        return nullptr;
+    }
+    // host memory is directly visible to all CPU devices
+    return pResource;
+}
+
+std::shared_ptr<IFence> CpuDevice::createFence(bool /*bShared*/)
+{
+    // every CPU fence can be used by all CPU devices
+    return std::make_shared<CpuFence>();
+}
+
+std::shared_ptr<IFence> CpuDevice::createSharedFence(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IFence> pFence)
+{
+    if (!std::dynamic_pointer_cast<CpuDevice>(pOtherDevice) || !std::dynamic_pointer_cast<CpuFence>(pFence))
+    {
+        assert(false && "Only CPU fences can be shared with a CPU device");
+        return nullptr;
+    }
+    // queues of all CPU devices signal and wait on CpuFence directly
+    return pFence;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "IDevice.h"
+
+// software device: resources live in host memory and every queue executes on its own thread
+struct CpuDevice : public IDevice
+{
+    CpuDevice();
+    ~CpuDevice();
+
+    // IDevice interface
+    virtual std::shared_ptr<IWindow> createWindow(uint32_t nSwapChainImages) override;
+    virtual std::shared_ptr<IQueue> createQueue(const std::wstring &sName, eQueueType eType = eQueueTypeDirect,
+        uint32_t nAllocators = s_nDefaultQueueAllocators) override;
+    virtual std::shared_ptr<IResource> createResource(const IResource::ResDesc& desc) override;
+    virtual std::shared_ptr<IResource> createSharedResource(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IResource> pResource) override;
+    virtual std::shared_ptr<IFence> createFence(bool bShared = false) override;
+    virtual std::shared_ptr<IFence> createSharedFence(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IFence> pFence) override;
+};
@@ -0,0 +1,139 @@
+#include "framework.h"
+#include "CpuFence.h"
+#include "CpuQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+
+namespace {
+    // waits on the condition variable for at most nTimeoutMs
+    template <typename Predicate>
+    bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, uint32_t nTimeoutMs, Predicate predicate)
+    {
+        if (nTimeoutMs == IFence::s_nInfinite)
+        {
+            cv.wait(lock, predicate);
+            return true;
+        }
+        return cv.wait_for(lock, std::chrono::milliseconds(nTimeoutMs), predicate);
+    }
+}
+
+void CpuFence::land(uint64_t value)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(value >= m_completedValue.load() && "Fence values must be monotonous");
+        m_completedValue.store(value);
+        // the waiter checks the fences under its own mutex - taking it here means no wake-up gets lost
+        for (Waiter* pWaiter : m_pWaiters)
+        {
+            std::lock_guard<std::mutex> waiterLock(pWaiter->m_mutex);
+            pWaiter->m_cv.notify_all();
+        }
+    }
+    m_cv.notify_all();
+}
+
+void CpuFence::waitLanded(uint64_t value)
+{
+    if (m_completedValue.load() >= value)
+        return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [&]() { return m_completedValue.load() >= value; });
+}
+
+void CpuFence::signalGpuFenceImpl(IQueue* pQueue, uint64_t value)
+{
+    assert(pQueue && "Queue cannot be null");
+    CpuQueue* pCpuQueue = static_cast<CpuQueue*>(pQueue);
+    pCpuQueue->enqueueSignal(std::static_pointer_cast<CpuFence>(shared_from_this()), value);
+}
+
+void CpuFence::signalCpuFenceImpl(uint64_t value)
+{
+    land(value);
+}
+
+void CpuFence::waitGpuFenceImpl(IQueue* pQueue, uint64_t value)
+{
+    assert(pQueue && "Queue cannot be null");
+    CpuQueue* pCpuQueue = static_cast<CpuQueue*>(pQueue);
+    pCpuQueue->enqueueWait(std::static_pointer_cast<CpuFence>(shared_from_this()), value);
+}
+
+uint64_t CpuFence::getLastLandedValueImpl()
+{
+    return m_completedValue.load();
+}
+
+bool CpuFence::waitCpuFenceImpl(uint64_t value, uint32_t nTimeoutMs)
+{
+    updateLastLandedValue(m_completedValue.load());
+    if (m_completedValue.load() >= value)
+        return true;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return waitFor(m_cv, lock, nTimeoutMs, [&]() { return m_completedValue.load() >= value; });
+}
+
+int CpuFence::waitManyImpl(std::span<const FenceTicket> tickets, bool bAll, uint32_t nTimeoutMs)
+{
+    // one waiter per thread, reused by all of its waits
+    thread_local Waiter waiter;
+
+    auto findLanded = [&]() -> int
+    {
+        int iLanded = -1;
+        for (size_t u = 0; u < tickets.size(); ++u)
+        {
+            auto pFence = static_cast<CpuFence*>(tickets[u].m_pFence.get());
+            bool bLanded = !pFence || pFence->m_completedValue.load() >= tickets[u].m_value;
+            if (bLanded != bAll)
+                return bLanded ? int(u) : -1;
+            if (bLanded)
+            {
+                iLanded = int(u);
+            }
+        }
+        return iLanded;
+    };
+
+    for (auto& ticket : tickets)
+    {
+        if (ticket.m_pFence)
+        {
+            assert(dynamic_cast<CpuFence*>(ticket.m_pFence.get()) && "Fences of different backends");
+            static_cast<CpuFence*>(ticket.m_pFence.get())->addWaiter(&waiter);
+        }
+    }
+
+    int iLanded = -1;
+    {
+        std::unique_lock<std::mutex> lock(waiter.m_mutex);
+        waitFor(waiter.m_cv, lock, nTimeoutMs, [&]() { return (iLanded = findLanded()) >= 0; });
+    }
+
+    for (auto& ticket : tickets)
+    {
+        if (ticket.m_pFence)
+        {
+            static_cast<CpuFence*>(ticket.m_pFence.get())->removeWaiter(&waiter);
+        }
+    }
+    return iLanded;
+}
+
+void CpuFence::addWaiter(Waiter* pWaiter)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pWaiters.push_back(pWaiter);
+}
+
+void CpuFence::removeWaiter(Waiter* pWaiter)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // the same fence may appear in several tickets - remove one registration per call
+    auto it = std::find(m_pWaiters.begin(), m_pWaiters.end(), pWaiter);
+    assert(it != m_pWaiters.end() && "Waiter is not registered");
+    m_pWaiters.erase(it);
+}
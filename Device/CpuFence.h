@@ -0,0 +1,39 @@
+#pragma once
+
+#include "IFence.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+class CpuFence : public IFence
+{
+public:
+    // called by the queue thread when the signal command is reached
+    void land(uint64_t value);
+    // blocks the calling thread until the fence reaches the value
+    void waitLanded(uint64_t value);
+
+private:
+    // IFence interface implementation
+    virtual void signalGpuFenceImpl(IQueue* pQueue, uint64_t value) override;
+    virtual void signalCpuFenceImpl(uint64_t value) override;
+    virtual void waitGpuFenceImpl(IQueue* pQueue, uint64_t value) override;
+    virtual uint64_t getLastLandedValueImpl() override;
+    virtual bool waitCpuFenceImpl(uint64_t value, uint32_t nTimeoutMs) override;
+    virtual int waitManyImpl(std::span<const FenceTicket> tickets, bool bAll, uint32_t nTimeoutMs) override;
+
+    // a thread waiting on several fences - registered with each of them while it waits
+    struct Waiter
+    {
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+    void addWaiter(Waiter* pWaiter);
+    void removeWaiter(Waiter* pWaiter);
+
+    std::atomic<uint64_t> m_completedValue = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Waiter*> m_pWaiters;
+};
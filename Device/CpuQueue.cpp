@@ -0,0 +1,191 @@
+#include "framework.h"
+#include "CpuQueue.h"
+#include "CpuCmdList.h"
+#include "CpuFence.h"
+#include <algorithm>
+#include <cassert>
+
+CpuQueue::CpuQueue(CpuDevice* pDevice, const std::wstring &sName, IDevice::eQueueType eType, uint32_t nAllocators)
+    : m_nAllocators(nAllocators)
+{
+    m_eType = eType;
+    setName(sName);
+    assert(nAllocators > 0 && "Queue needs at least one command allocator");
+
+    // Create fence for tracking of the submitted work
+    m_pFence = pDevice->createFence();
+    assert(m_pFence && "Failed to create allocator fence");
+
+    m_pDevice = pDevice->shared_from_this();
+
+    // timestamps are steady_clock nanoseconds
+    m_timestamps.resize(Profiler::s_nMaxTimestamps);
+    m_pProfiler = std::make_unique<Profiler>(m_timestamps.data(), 1000000000ull);
+
+    m_thread = std::thread(&CpuQueue::threadFunc, this);
+}
+
+CpuQueue::~CpuQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bExit = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+std::unique_ptr<IQueue::RecordingPool> CpuQueue::createRecordingPool()
+{
+    return std::make_unique<Pool>();
+}
+
+std::shared_ptr<ICmdList> CpuQueue::startRecordingImpl(RecordingPool* pPool)
+{
+    Pool& pool = *static_cast<Pool*>(pPool);
+    std::unique_lock<std::mutex> lock(pool.m_mutex);
+    for ( ; ; )
+    {
+        uint64_t landedValue = m_pFence->getLastLandedValue();
+        uint32_t nInFlight = 0;
+        uint64_t oldestValue = UINT64_MAX;
+        for (auto& pCmdList : pool.m_pCmdLists)
+        {
+            // held by the caller or by the worker thread
+            if (pCmdList.use_count() != 1)
+            {
+                if (!pCmdList->isRecording() && pCmdList->getFenceValue() > landedValue)
+                {
+                    ++nInFlight;
+                    oldestValue = std::min(oldestValue, pCmdList->getFenceValue());
+                }
+                continue;
+            }
+            // executed, or dropped without being executed
+            pCmdList->flushBarriers();
+            pCmdList->reset();
+            pCmdList->beginRecording(m_pProfiler.get());
+            pCmdList->setRecording(true);
+            return pCmdList;
+        }
+
+        // the worker is nAllocators submissions of this thread behind - wait for the oldest one. the pool is
+        // unlocked meanwhile, a submission of one of its lists would block on it
+        if (nInFlight >= m_nAllocators)
+        {
+            lock.unlock();
+            m_pFence->waitCpuFence(oldestValue);
+            lock.lock();
+            continue;
+        }
+        auto pCmdList = std::make_shared<CpuCmdList>();
+        pCmdList->setPool(&pool);
+        pCmdList->setTimestamps(m_timestamps.data());
+        pCmdList->beginRecording(m_pProfiler.get());
+        pCmdList->setRecording(true);
+        pool.m_pCmdLists.push_back(pCmdList);
+        return pCmdList;
+    }
+}
+
+void CpuQueue::executeImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue)
+{
+    deferImpl(pCmdLists, fenceValue);
+
+    // one wake-up of the worker for the whole batch
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& pCmdList : pCmdLists)
+        {
+            Work work;
+            work.m_eType = eWorkExecute;
+            work.m_pCmdList = std::static_pointer_cast<CpuCmdList>(pCmdList);
+            m_work.push_back(std::move(work));
+        }
+    }
+    m_cv.notify_one();
+}
+
+void CpuQueue::deferImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue)
+{
+    for (auto& pCmdList : pCmdLists)
+    {
+        assert(pCmdList && "Command list cannot be null");
+        auto pCpuCmdList = static_cast<CpuCmdList*>(pCmdList.get());
+        pCpuCmdList->flushBarriers();
+        // the lists may come from the pools of several recording threads
+        std::lock_guard<std::mutex> lock(pCpuCmdList->getPool()->m_mutex);
+        pCpuCmdList->setRecording(false);
+        pCpuCmdList->setFenceValue(fenceValue);
+    }
+}
+
+void CpuQueue::flush()
+{
+    // Wait for all submitted work to complete by waiting for the fence
+    m_pFence->waitCpuFence(m_pFence->getLastSignalledValue());
+}
+
+void CpuQueue::enqueueSignal(std::shared_ptr<CpuFence> pFence, uint64_t value)
+{
+    Work work;
+    work.m_eType = eWorkSignal;
+    work.m_pFence = std::move(pFence);
+    work.m_value = value;
+    enqueue(std::move(work));
+}
+
+void CpuQueue::enqueueWait(std::shared_ptr<CpuFence> pFence, uint64_t value)
+{
+    Work work;
+    work.m_eType = eWorkWait;
+    work.m_pFence = std::move(pFence);
+    work.m_value = value;
+    enqueue(std::move(work));
+}
+
+void CpuQueue::enqueue(Work&& work)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_work.push_back(std::move(work));
+    }
+    m_cv.notify_one();
+}
+
+void CpuQueue::threadFunc()
+{
+    Trace::setThreadName(m_sTraceName.c_str());
+    for ( ; ; )
+    {
+        Work work;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_bExit || !m_work.empty(); });
+            // pending work is drained before exiting so that nobody waits on a fence forever
+            if (m_work.empty())
+                return;
+            work = std::move(m_work.front());
+            m_work.pop_front();
+        }
+
+        switch (work.m_eType)
+        {
+        case eWorkExecute:
+        {
+            TRACE_ZONE("execute");
+            work.m_pCmdList->run();
+            break;
+        }
+        case eWorkSignal:
+            work.m_pFence->land(work.m_value);
+            break;
+        case eWorkWait:
+            work.m_pFence->waitLanded(work.m_value);
+            break;
+        default:
+            assert(false && "Unknown work type");
+            break;
+        }
+    }
+}
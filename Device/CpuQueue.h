@@ -0,0 +1,66 @@
+#pragma once
+
+#include "IQueue.hpp"
+#include "CpuDevice.h"
+#include <memory>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class CpuCmdList;
+class CpuFence;
+
+// executes command lists and fence operations in submission order on its own worker thread
+class CpuQueue : public IQueue
+{
+public:
+    CpuQueue(CpuDevice* pDevice, const std::wstring &sName, IDevice::eQueueType eType, uint32_t nAllocators);
+    ~CpuQueue();
+
+    virtual void flush() override;
+
+    // used by CpuFence to put fence operations into the queue
+    void enqueueSignal(std::shared_ptr<CpuFence> pFence, uint64_t value);
+    void enqueueWait(std::shared_ptr<CpuFence> pFence, uint64_t value);
+
+private:
+    // command lists of one recording thread, guarded by m_mutex
+    struct Pool : public RecordingPool
+    {
+        std::vector<std::shared_ptr<CpuCmdList>> m_pCmdLists;
+    };
+
+    virtual void executeImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue) override;
+    virtual void deferImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue) override;
+    virtual std::shared_ptr<ICmdList> startRecordingImpl(RecordingPool* pPool) override;
+    virtual std::unique_ptr<RecordingPool> createRecordingPool() override;
+
+    enum eWork
+    {
+        eWorkExecute,
+        eWorkSignal,
+        eWorkWait
+    };
+    struct Work
+    {
+        eWork m_eType;
+        std::shared_ptr<CpuCmdList> m_pCmdList;
+        std::shared_ptr<CpuFence> m_pFence;
+        uint64_t m_value = 0;
+    };
+    void enqueue(Work&& work);
+    void threadFunc();
+
+    // recorded commands are the allocator memory of the CPU backend - up to m_nAllocators lists per recording
+    // thread are kept in flight
+    uint32_t m_nAllocators = 0;
+    // written by the worker thread, read by m_pProfiler
+    std::vector<uint64_t> m_timestamps;
+    std::deque<Work> m_work;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_bExit = false;
+    std::thread m_thread;
+};
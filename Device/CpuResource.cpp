@@ -0,0 +1,76 @@
+#include "framework.h"
+#include "CpuResource.h"
+#include "MipChain.h"
+#include <cassert>
+#include <cstring>
+
+CpuResource::CpuResource(const ResDesc& desc)
+    : m_desc(desc)
+{
+    size_t nBytes = 0;
+    if (desc.m_nDims == 1)
+    {
+        // buffers are sized in bytes, same as D3D12 buffers
+        nBytes = desc.m_res[0];
+    }
+    else
+    {
+        assert(desc.m_nMips >= 1 && desc.m_nMips <= MipChain::getFullCount(desc.m_res[0], desc.m_res[1]) && "Invalid number of mips");
+        for (uint32_t uMip = 0; uMip < desc.m_nMips; ++uMip)
+        {
+            int3 vRes = getMipRes(uMip);
+            m_mipOffsets.push_back(nBytes);
+            nBytes += size_t(getRowPitch(uMip)) * getBlockRows(desc.m_format, uint32_t(vRes.y)) * uint32_t(vRes.z);
+        }
+    }
+    assert(nBytes > 0 && "Empty resource");
+    m_data.resize(nBytes);
+}
+
+int3 CpuResource::getMipRes(uint32_t uMip) const
+{
+    return int3(int(MipChain::getLevelSize(m_desc.m_res[0], uMip)), int(MipChain::getLevelSize(m_desc.m_res[1], uMip)),
+        m_desc.m_nDims == 3 ? int(MipChain::getLevelSize(m_desc.m_res[2], uMip)) : 1);
+}
+
+uint32_t CpuResource::getRowPitch(uint32_t uMip) const
+{
+    if (m_desc.m_nDims == 1)
+        return m_desc.m_res[0];
+    return getPackedRowPitch(m_desc.m_format, uint32_t(getMipRes(uMip).x));
+}
+
+uint8_t* CpuResource::getTexel(const int3& vTexel, uint32_t uMip)
+{
+    assert(m_desc.m_nDims > 1 && "Buffers have no texels");
+    assert(uMip < m_desc.m_nMips && "Mip is out of range");
+    int nBlockSize = int(getBlockSize(m_desc.m_format));
+    uint32_t nRowPitch = getRowPitch(uMip);
+    size_t nSlicePitch = size_t(nRowPitch) * getBlockRows(m_desc.m_format, uint32_t(getMipRes(uMip).y));
+    return m_data.data() + m_mipOffsets[uMip] + vTexel.z * nSlicePitch + size_t(vTexel.y / nBlockSize) * nRowPitch +
+        size_t(vTexel.x / nBlockSize) * getTexelSize();
+}
+
+bool CpuResource::contains(const ibox3& box, uint32_t uMip) const
+{
+    return uMip < m_desc.m_nMips && ibox3(int3(0, 0, 0), getMipRes(uMip) - 1).contains(box);
+}
+
+void CpuResource::getDesc(IResource::ResDesc& outDesc)
+{
+    outDesc = m_desc;
+}
+
+void CpuResource::writeTo(const char* pData, uint32_t nBytes)
+{
+    assert(m_desc.m_nDims == 1);
+
+    // Check if we're trying to write more data than the resource can hold
+    if (nBytes > m_data.size())
+    {
+        assert(false && "Attempting to write more data than the resource can hold");
+        return;
+    }
+
+    memcpy(m_data.data(), pData, nBytes);
+}
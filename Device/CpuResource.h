@@ -0,0 +1,41 @@
+#pragma once
+
+#include "IResource.h"
+#include <vector>
+#include <string>
+
+// resource backed by host memory. textures are stored tightly packed (rows of width * bytesPerPixel, or rows of
+// blocks for the block-compressed formats), mip after mip
+class CpuResource : public IResource
+{
+public:
+    CpuResource(const ResDesc& desc);
+
+    // IResource interface
+    virtual void getDesc(ResDesc& outDesc) override;
+    virtual void writeTo(const char* pData, uint32_t nBytes) override;
+    // the storage itself - always persistently mapped
+    virtual void* map() override { return m_data.data(); }
+    virtual void unmap() override { }
+    virtual void setName(const std::wstring& name) override { m_sName = name; }
+
+    uint8_t* getData() { return m_data.data(); }
+    size_t getSize() const { return m_data.size(); }
+    // bytes between two consecutive rows (of blocks) of a mip of a texture (for buffers - the whole size)
+    uint32_t getRowPitch(uint32_t uMip = 0) const;
+    eFormat getFormat() const { return m_desc.m_format; }
+    // bytes per texel, or per block
+    uint32_t getTexelSize() const { return getBytesPerPixel(m_desc.m_format); }
+    // textures only. with block-compressed formats - the block that holds the texel
+    uint8_t* getTexel(const int3& vTexel, uint32_t uMip = 0);
+    bool contains(const ibox3& box, uint32_t uMip = 0) const;
+
+private:
+    int3 getMipRes(uint32_t uMip) const;
+
+    ResDesc m_desc;
+    std::vector<uint8_t> m_data;
+    // byte offset of every mip
+    std::vector<size_t> m_mipOffsets;
+    std::wstring m_sName;
+};
@@ -2,6 +2,7 @@
 #include "D3D12CmdList.h"
 #include "D3D12Resource.h"
 #include "IResource.h"
+#include <algorithm>
 #include <cassert>
 
 namespace {
@@ -27,22 +28,28 @@ D3D12CmdList::D3D12CmdList(ComPtr<ID3D12GraphicsCommandList> cmdList)
 {
 }
 
-void D3D12CmdList::barrier(IResource* pResource, eBarrier eStateBefore, eBarrier eStateAfter)
+void D3D12CmdList::barriersImpl(std::span<const Barrier> barriers)
 {
-    auto pD3D12Resource = dynamic_cast<D3D12Resource*>(pResource);
-    assert(pD3D12Resource && "Failed to cast to D3D12 resource");
-
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = pD3D12Resource->getResource();
-    barrier.Transition.StateBefore = convertState(eStateBefore);
-    barrier.Transition.StateAfter = convertState(eStateAfter);
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    m_cmdList->ResourceBarrier(1, &barrier);
+    m_d3d12Barriers.clear();
+    for (auto& b : barriers)
+    {
+        auto pD3D12Resource = dynamic_cast<D3D12Resource*>(b.m_pResource);
+        assert(pD3D12Resource && "Failed to cast to D3D12 resource");
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.pResource = pD3D12Resource->getResource();
+        barrier.Transition.StateBefore = convertState(b.m_eStateBefore);
+        barrier.Transition.StateAfter = convertState(b.m_eStateAfter);
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        m_d3d12Barriers.push_back(barrier);
+    }
+    // all pending transitions in one call
+    m_cmdList->ResourceBarrier(UINT(m_d3d12Barriers.size()), m_d3d12Barriers.data());
 }
 
-void D3D12CmdList::copy(IResource* pDst, IResource* pSrc)
+void D3D12CmdList::copyImpl(IResource* pDst, IResource* pSrc)
 {
     auto pD3D12Dst = dynamic_cast<D3D12Resource*>(pDst);
     assert(pD3D12Dst && "Failed to cast destination to D3D12 resource");
@@ -53,7 +60,41 @@ void D3D12CmdList::copy(IResource* pDst, IResource* pSrc)
     m_cmdList->CopyResource(pD3D12Dst->getResource(), pD3D12Src->getResource());
 }
 
-void D3D12CmdList::copyFromStaging(IResource* pDstTexture2D, IResource* pSrcBuffer, uint32_t nSrcBytesPerRow)
+void D3D12CmdList::copyRegionImpl(IResource* pDst, const int3& dstOffset, IResource* pSrc, const ibox3& srcBox)
+{
+    auto pD3D12Dst = dynamic_cast<D3D12Resource*>(pDst);
+    assert(pD3D12Dst && "Failed to cast destination to D3D12 resource");
+
+    auto pD3D12Src = dynamic_cast<D3D12Resource*>(pSrc);
+    assert(pD3D12Src && "Failed to cast source to D3D12 resource");
+    // decoding block-compressed textures would need a shader - copy queues can't do that
+    assert(pD3D12Dst->getResource()->GetDesc().Format == pD3D12Src->getResource()->GetDesc().Format &&
+        "Copies between formats are not supported");
+
+    D3D12_TEXTURE_COPY_LOCATION dst = {};
+    dst.pResource = pD3D12Dst->getResource();
+    dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dst.SubresourceIndex = 0;
+
+    D3D12_TEXTURE_COPY_LOCATION src = {};
+    src.pResource = pD3D12Src->getResource();
+    src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    src.SubresourceIndex = 0;
+
+    // D3D12_BOX is exclusive at the far end
+    D3D12_BOX box = {};
+    box.left = UINT(srcBox.m_mins.x);
+    box.top = UINT(srcBox.m_mins.y);
+    box.front = UINT(srcBox.m_mins.z);
+    box.right = UINT(srcBox.m_maxs.x + 1);
+    box.bottom = UINT(srcBox.m_maxs.y + 1);
+    box.back = UINT(srcBox.m_maxs.z + 1);
+
+    m_cmdList->CopyTextureRegion(&dst, UINT(dstOffset.x), UINT(dstOffset.y), UINT(dstOffset.z), &src, &box);
+}
+
+void D3D12CmdList::copyFromStagingImpl(IResource* pDstTexture2D, const ibox2& dstRect, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow,
+    uint32_t uMip)
 {
     auto pD3D12Texture = dynamic_cast<D3D12Resource*>(pDstTexture2D);
     assert(pD3D12Texture && "Failed to cast texture to D3D12 resource");
@@ -61,30 +102,62 @@ void D3D12CmdList::copyFromStaging(IResource* pDstTexture2D, IResource* pSrcBuff
     auto pD3D12Buffer = dynamic_cast<D3D12Resource*>(pSrcBuffer);
     assert(pD3D12Buffer && "Failed to cast buffer to D3D12 resource");
 
-    // Get resource descriptions to determine dimensions
-    IResource::ResDesc textureDesc, bufferDesc;
-    pDstTexture2D->getDesc(textureDesc);
-    pSrcBuffer->getDesc(bufferDesc);
-
-    uint32_t nBytesPerPixel = IResource::getBytesPerPixel(textureDesc.m_format);
-    uint32_t srcWidth = nSrcBytesPerRow / nBytesPerPixel;
-    uint32_t srcHeight = bufferDesc.m_res[0] / nSrcBytesPerRow;
+    // footprints of block-compressed textures are made of whole blocks, also where the rect ends at the edge of a small mip
+    IResource::ResDesc desc;
+    pD3D12Texture->getDesc(desc);
+    int nBlockSize = int(IResource::getBlockSize(desc.m_format));
+    int2 vExtent = (dstRect.diagonal() + int2(nBlockSize, nBlockSize)) / nBlockSize * nBlockSize;
+    assert(nSrcOffset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT == 0 && "Misaligned staging offset");
+    assert(nSrcBytesPerRow % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT == 0 && "Misaligned staging row pitch");
 
     // Set up copy locations
     D3D12_TEXTURE_COPY_LOCATION dst = {};
     dst.pResource = pD3D12Texture->getResource();
     dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-    dst.SubresourceIndex = 0;
+    dst.SubresourceIndex = uMip;
 
     D3D12_TEXTURE_COPY_LOCATION src = {};
     src.pResource = pD3D12Buffer->getResource();
     src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-    src.PlacedFootprint.Offset = 0;
-    src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    src.PlacedFootprint.Footprint.Width = srcWidth;
-    src.PlacedFootprint.Footprint.Height = srcHeight;
+    src.PlacedFootprint.Offset = nSrcOffset;
+    // rows of the footprint are rows of blocks for the block-compressed formats
+    src.PlacedFootprint.Footprint.Format = dst.pResource->GetDesc().Format;
+    src.PlacedFootprint.Footprint.Width = UINT(vExtent.x);
+    src.PlacedFootprint.Footprint.Height = UINT(vExtent.y);
     src.PlacedFootprint.Footprint.Depth = 1;
     src.PlacedFootprint.Footprint.RowPitch = nSrcBytesPerRow;  // Use provided bytes per row
 
-    m_cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    m_cmdList->CopyTextureRegion(&dst, UINT(dstRect.m_mins.x), UINT(dstRect.m_mins.y), 0, &src, nullptr);
+}
+
+void D3D12CmdList::writeTimestampImpl(uint32_t uSlot)
+{
+    assert(m_pQueryHeap && "Command list has no query heap");
+    m_cmdList->EndQuery(m_pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, uSlot);
+}
+
+void D3D12CmdList::resolveTimestamps(ID3D12Resource* pReadback)
+{
+    m_slots.clear();
+    for (auto& scope : getScopes())
+    {
+        if (scope.m_uBegin != Profiler::s_nInvalidSlot)
+            m_slots.push_back(scope.m_uBegin);
+        if (scope.m_uEnd != Profiler::s_nInvalidSlot)
+            m_slots.push_back(scope.m_uEnd);
+    }
+    std::sort(m_slots.begin(), m_slots.end());
+
+    // one resolve per run of consecutive slots - the profiler hands them out in runs mostly
+    for (size_t uFirst = 0; uFirst < m_slots.size(); )
+    {
+        size_t uLast = uFirst;
+        while (uLast + 1 < m_slots.size() && m_slots[uLast + 1] == m_slots[uLast] + 1)
+        {
+            ++uLast;
+        }
+        m_cmdList->ResolveQueryData(m_pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, m_slots[uFirst], UINT(uLast - uFirst + 1),
+            pReadback, uint64_t(m_slots[uFirst]) * sizeof(uint64_t));
+        uFirst = uLast + 1;
+    }
 }
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "ICmdList.h"
+#include "IQueue.hpp"
 #include <d3d12.h>
 #include <wrl/client.h>
+#include <vector>
 
 using Microsoft::WRL::ComPtr;
 
@@ -11,15 +13,39 @@ class D3D12CmdList : public ICmdList
 public:
     D3D12CmdList(ComPtr<ID3D12GraphicsCommandList> cmdList);
 
-    // ICmdList interface
-    virtual void barrier(IResource* pResource, eBarrier eStateBefore, eBarrier eStateAfter) override;
-    virtual void copy(IResource* pDst, IResource* pSrc) override;
-    virtual void copyFromStaging(IResource* pDstTexture2D, IResource* pSrcBuffer, uint32_t nSrcBytesPerRow) override;
-
     // Getter for the underlying D3D12 command list
     ID3D12GraphicsCommandList* getCmdList() const { return m_cmdList.Get(); }
 
+    // pool bookkeeping of D3D12Queue
+    IQueue::RecordingPool* getPool() const { return m_pPool; }
+    void setPool(IQueue::RecordingPool* pPool) { m_pPool = pPool; }
+    uint32_t getAllocatorIndex() const { return m_uAllocator; }
+    void setAllocatorIndex(uint32_t uAlloc) { m_uAllocator = uAlloc; }
+    bool isRecording() const { return m_bRecording; }
+    void setRecording(bool bRecording) { m_bRecording = bRecording; }
+    // timestamp queries of the queue's profiler
+    void setQueryHeap(ID3D12QueryHeap* pQueryHeap) { m_pQueryHeap = pQueryHeap; }
+    // copies the timestamps written by the list into the readback buffer - recorded right before Close()
+    void resolveTimestamps(ID3D12Resource* pReadback);
+
+protected:
+    // ICmdList interface
+    virtual void barriersImpl(std::span<const Barrier> barriers) override;
+    virtual void copyImpl(IResource* pDst, IResource* pSrc) override;
+    virtual void copyFromStagingImpl(IResource* pDstTexture2D, const ibox2& dstRect, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow,
+        uint32_t uMip) override;
+    virtual void copyRegionImpl(IResource* pDst, const int3& dstOffset, IResource* pSrc, const ibox3& srcBox) override;
+    virtual void writeTimestampImpl(uint32_t uSlot) override;
+
 private:
     ComPtr<ID3D12GraphicsCommandList> m_cmdList;
+    IQueue::RecordingPool* m_pPool = nullptr;
+    uint32_t m_uAllocator = 0;
+    bool m_bRecording = false;
+    // scratch array for ResourceBarrier
+    std::vector<D3D12_RESOURCE_BARRIER> m_d3d12Barriers;
+    ID3D12QueryHeap* m_pQueryHeap = nullptr;
+    // scratch array for resolveTimestamps()
+    std::vector<uint32_t> m_slots;
 };
 
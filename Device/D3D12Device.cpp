@@ -17,6 +17,12 @@ namespace {
             return DXGI_FORMAT_UNKNOWN;
         case IResource::eFormatRGBA8:
             return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case IResource::eFormatBC1:
+            return DXGI_FORMAT_BC1_UNORM;
+        case IResource::eFormatBC3:
+            return DXGI_FORMAT_BC3_UNORM;
+        case IResource::eFormatBC7:
+            return DXGI_FORMAT_BC7_UNORM;
         default:
             assert(false && "Unsupported format");
             return DXGI_FORMAT_UNKNOWN;
@@ -114,18 +120,35 @@ D3D12Device::D3D12Device(bool bUseIntegratedGpu)
     m_sDesc = desc.Description;
 }
 
+D3D12Device::~D3D12Device()
+{
+    // a lost device has nothing left in flight worth waiting for
+    bool bLost = m_pDevice && FAILED(m_pDevice->GetDeviceRemovedReason());
+    m_retireQueue.drain(bLost ? 0 : RetireQueue::s_nDrainTimeoutMs);
+}
+
 std::shared_ptr<IWindow> D3D12Device::createWindow(uint32_t nSwapChainImages)
 {
     return D3D12Window::create(this, nSwapChainImages);
 }
 
-std::shared_ptr<IQueue> D3D12Device::createQueue(const std::wstring &sName)
+std::shared_ptr<IQueue> D3D12Device::createQueue(const std::wstring &sName, eQueueType eType, uint32_t nAllocators)
 {
-    return std::make_shared<D3D12Queue>(this, sName);
+    return std::make_shared<D3D12Queue>(this, sName, eType, nAllocators);
 }
 
 std::shared_ptr<IResource> D3D12Device::createResource(const IResource::ResDesc& desc)
 {
+    // block-compressed textures are made of whole blocks, and row-major layouts (cross-adapter sharing, staging) can't hold them
+    uint32_t nBlockSize = IResource::getBlockSize(desc.m_format);
+    assert((nBlockSize == 1 || (desc.m_res[0] % nBlockSize == 0 && desc.m_res[1] % nBlockSize == 0)) && "Texture size is not a multiple of the block size");
+    assert((nBlockSize == 1 || (!desc.m_isShared && !desc.m_isStaging)) && "Block-compressed textures can't be shared or staging");
+    (void)nBlockSize;
+    assert((!desc.m_isReadback || (desc.m_nDims == 1 && !desc.m_isStaging && !desc.m_isShared)) && "Readback resources are plain buffers");
+    assert((!desc.m_isPersistentlyMapped || desc.m_isStaging || desc.m_isReadback) && "Only staging and readback resources can be mapped");
+    // row-major textures have a single subresource
+    assert((desc.m_nMips == 1 || (!desc.m_isShared && !desc.m_isStaging)) && "Shared and staging textures can't have mips");
+
     // Create resource description
     D3D12_RESOURCE_DESC resourceDesc = {};
     resourceDesc.Dimension = desc.m_nDims == 1 ? D3D12_RESOURCE_DIMENSION_BUFFER :
@@ -134,11 +157,11 @@ std::shared_ptr<IResource> D3D12Device::createResource(const IResource::ResDesc&
     resourceDesc.Width = desc.m_res[0];
     resourceDesc.Height = desc.m_res[1];
     resourceDesc.DepthOrArraySize = desc.m_res[2];
-    resourceDesc.MipLevels = 1;
+    resourceDesc.MipLevels = desc.m_nDims == 1 ? 1 : UINT16(desc.m_nMips);
     resourceDesc.Format = convertFormat(desc.m_format);
     resourceDesc.SampleDesc.Count = 1;
     resourceDesc.SampleDesc.Quality = 0;
-    if (desc.m_isShared || desc.m_isStaging)
+    if (desc.m_isShared || desc.m_isStaging || desc.m_isReadback)
     {
         resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
     }
@@ -153,7 +176,7 @@ std::shared_ptr<IResource> D3D12Device::createResource(const IResource::ResDesc&
     // Create the resource
     ComPtr<ID3D12Resource> resource;
     D3D12_HEAP_PROPERTIES heapProps = {
-        desc.m_isStaging ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT,
+        desc.m_isStaging ? D3D12_HEAP_TYPE_UPLOAD : desc.m_isReadback ? D3D12_HEAP_TYPE_READBACK : D3D12_HEAP_TYPE_DEFAULT,
         D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
         D3D12_MEMORY_POOL_UNKNOWN,
         0, 0
@@ -169,7 +192,8 @@ std::shared_ptr<IResource> D3D12Device::createResource(const IResource::ResDesc&
         &heapProps,
         heapFlags,
         &resourceDesc,
-        D3D12_RESOURCE_STATE_COMMON,
+        // readback heaps can only ever be copied into
+        desc.m_isReadback ? D3D12_RESOURCE_STATE_COPY_DEST : D3D12_RESOURCE_STATE_COMMON,
         nullptr,
         IID_PPV_ARGS(&resource)
     );
@@ -180,7 +204,7 @@ std::shared_ptr<IResource> D3D12Device::createResource(const IResource::ResDesc&
         return nullptr;
     }
 
-    return std::make_shared<D3D12Resource>(resource);
+    return std::make_shared<D3D12Resource>(resource, desc.m_isPersistentlyMapped);
 }
 
 std::shared_ptr<IResource> D3D12Device::createSharedResource(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IResource> pResource)
@@ -240,13 +264,50 @@ std::shared_ptr<IResource> D3D12Device::createSharedResource(std::shared_ptr<IDe
     return std::make_shared<D3D12Resource>(sharedResource);
 }
 
-std::shared_ptr<IFence> D3D12Device::createFence()
+std::shared_ptr<IFence> D3D12Device::createFence(bool bShared)
 {
     ComPtr<ID3D12Fence> fence;
-    HRESULT hr = m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
+    D3D12_FENCE_FLAGS flags = bShared ? (D3D12_FENCE_FLAG_SHARED | D3D12_FENCE_FLAG_SHARED_CROSS_ADAPTER) : D3D12_FENCE_FLAG_NONE;
+    HRESULT hr = m_pDevice->CreateFence(0, flags, IID_PPV_ARGS(&fence));
     if (FAILED(hr))
     {
         return nullptr;
     }
     return std::make_shared<D3D12Fence>(fence);
 }
+
+std::shared_ptr<IFence> D3D12Device::createSharedFence(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IFence> pFence)
+{
+    auto pOtherD3D12Device = std::dynamic_pointer_cast<D3D12Device>(pOtherDevice);
+    auto pD3D12Fence = std::dynamic_pointer_cast<D3D12Fence>(pFence);
+    if (!pOtherD3D12Device || !pD3D12Fence)
+    {
+        assert(false && "Invalid device or fence type for sharing");
+        return nullptr;
+    }
+    if (pOtherD3D12Device->m_pDevice == this->m_pDevice)
+    {
+        // if it's the same device - no need to share
+        return pFence;
+    }
+
+    HANDLE sharedHandle = nullptr;
+    HRESULT hr = pOtherD3D12Device->getDevice()->CreateSharedHandle(pD3D12Fence->getFence(), nullptr, GENERIC_ALL, nullptr, &sharedHandle);
+    if (FAILED(hr))
+    {
+        assert(false && "Failed to create shared fence handle - was the fence created with bShared?");
+        return nullptr;
+    }
+    ComPtr<ID3D12Fence> sharedFence;
+    hr = m_pDevice->OpenSharedHandle(sharedHandle, IID_PPV_ARGS(&sharedFence));
+    CloseHandle(sharedHandle);
+    if (FAILED(hr))
+    {
+        assert(false && "Failed to open shared fence handle");
+        return nullptr;
+    }
+
+    // queues of this device signal and wait on the opened fence, everybody else keeps using the original one
+    pD3D12Fence->addSharedFence(m_pDevice, sharedFence);
+    return pFence;
+}
@@ -10,6 +10,7 @@ using Microsoft::WRL::ComPtr;
 struct D3D12Device : public IDevice
 {
     D3D12Device(bool bUseIntegratedGpu);
+    ~D3D12Device();
 
     // Getters for device and factory
     ID3D12Device* getDevice() const { return m_pDevice.Get(); }
@@ -17,10 +18,12 @@ struct D3D12Device : public IDevice
 
     // IDevice interface
     virtual std::shared_ptr<IWindow> createWindow(uint32_t nSwapChainImages) override;
-    virtual std::shared_ptr<IQueue> createQueue(const std::wstring &sName) override;
+    virtual std::shared_ptr<IQueue> createQueue(const std::wstring &sName, eQueueType eType = eQueueTypeDirect,
+        uint32_t nAllocators = s_nDefaultQueueAllocators) override;
     virtual std::shared_ptr<IResource> createResource(const IResource::ResDesc& desc) override;
     virtual std::shared_ptr<IResource> createSharedResource(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IResource> pResource) override;
-    virtual std::shared_ptr<IFence> createFence() override;
+    virtual std::shared_ptr<IFence> createFence(bool bShared = false) override;
+    virtual std::shared_ptr<IFence> createSharedFence(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IFence> pFence) override;
 
 private:
     ComPtr<ID3D12Device> m_pDevice;
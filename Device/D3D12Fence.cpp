@@ -1,12 +1,104 @@
 #include "D3D12Fence.h"
 #include "D3D12Queue.h"
 #include <cassert>
+#include <mutex>
+#include <vector>
+
+namespace {
+    // events for CPU waits. an event is handed out again only once the fence it was armed for has reached
+    // the value - SetEventOnCompletion() cannot be cancelled after a timeout
+    class EventPool
+    {
+    public:
+        ~EventPool()
+        {
+            for (auto& entry : m_entries)
+            {
+                CloseHandle(entry.m_hEvent);
+            }
+        }
+        HANDLE acquire()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (size_t u = 0; u < m_entries.size(); ++u)
+                {
+                    Entry& entry = m_entries[u];
+                    if (entry.m_pFence->GetCompletedValue() < entry.m_value)
+                        continue;
+                    HANDLE hEvent = entry.m_hEvent;
+                    m_entries[u] = std::move(m_entries.back());
+                    m_entries.pop_back();
+                    // the fence may have set it without anyone waiting
+                    ResetEvent(hEvent);
+                    return hEvent;
+                }
+            }
+            HANDLE hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+            assert(hEvent != nullptr && "Failed to create event");
+            return hEvent;
+        }
+        void release(HANDLE hEvent, ID3D12Fence* pFence, uint64_t value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.push_back(Entry{ hEvent, pFence, value });
+        }
+
+    private:
+        struct Entry
+        {
+            HANDLE m_hEvent;
+            ComPtr<ID3D12Fence> m_pFence;
+            uint64_t m_value;
+        };
+        std::mutex m_mutex;
+        std::vector<Entry> m_entries;
+    };
+    EventPool& getEventPool()
+    {
+        static EventPool pool;
+        return pool;
+    }
+}
+
+D3D12Fence::D3D12Fence(ComPtr<ID3D12Fence> fence)
+    : m_pFence(fence)
+{
+    HRESULT hr = m_pFence->GetDevice(IID_PPV_ARGS(&m_pDevice));
+    assert(SUCCEEDED(hr) && "Failed to get the device of the fence");
+}
+
+void D3D12Fence::addSharedFence(ComPtr<ID3D12Device> pDevice, ComPtr<ID3D12Fence> pFence)
+{
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+    for (auto& shared : m_sharedFences)
+    {
+        if (shared.m_pDevice == pDevice)
+            return;  // opened on this device already
+    }
+    m_sharedFences.push_back(SharedFence{ pDevice, pFence });
+}
+
+ID3D12Fence* D3D12Fence::getFenceFor(IQueue* pQueue)
+{
+    ID3D12Device* pDevice = static_cast<D3D12Device*>(pQueue->getDevice())->getDevice();
+    if (pDevice == m_pDevice.Get())
+        return m_pFence.Get();
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+    for (auto& shared : m_sharedFences)
+    {
+        if (shared.m_pDevice.Get() == pDevice)
+            return shared.m_pFence.Get();
+    }
+    assert(false && "Fence is not shared with the device of the queue");
+    return m_pFence.Get();
+}
 
 void D3D12Fence::signalGpuFenceImpl(IQueue* pQueue, uint64_t value)
 {
     assert(pQueue && "Queue cannot be null");
     D3D12Queue* pD3D12Queue = static_cast<D3D12Queue*>(pQueue);
-    HRESULT hr = pD3D12Queue->getQueue12()->Signal(m_pFence.Get(), value);
+    HRESULT hr = pD3D12Queue->getQueue12()->Signal(getFenceFor(pQueue), value);
     assert(SUCCEEDED(hr) && "Failed to signal fence");
 
 #ifndef NDEBUG
@@ -14,11 +106,19 @@ void D3D12Fence::signalGpuFenceImpl(IQueue* pQueue, uint64_t value)
 #endif
 }
 
+void D3D12Fence::signalCpuFenceImpl(uint64_t value)
+{
+    // a lost device completes all its fences anyway
+    HRESULT hr = m_pFence->Signal(value);
+    assert((SUCCEEDED(hr) || hr == DXGI_ERROR_DEVICE_REMOVED) && "Failed to signal fence");
+    (void)hr;
+}
+
 void D3D12Fence::waitGpuFenceImpl(IQueue* pQueue, uint64_t value)
 {
     assert(pQueue && "Queue cannot be null");
     D3D12Queue* pD3D12Queue = static_cast<D3D12Queue*>(pQueue);
-    HRESULT hr = pD3D12Queue->getQueue12()->Wait(m_pFence.Get(), value);
+    HRESULT hr = pD3D12Queue->getQueue12()->Wait(getFenceFor(pQueue), value);
     assert(SUCCEEDED(hr) && "Failed to wait for fence");
 
 #ifndef NDEBUG
@@ -30,20 +130,69 @@ uint64_t D3D12Fence::getLastLandedValueImpl()
     return m_pFence->GetCompletedValue();
 }
 
-void D3D12Fence::waitCpuFenceImpl(uint64_t value)
+bool D3D12Fence::waitCpuFenceImpl(uint64_t value, uint32_t nTimeoutMs)
 {
     auto completedValue = m_pFence->GetCompletedValue();
     updateLastLandedValue(completedValue);
-    if (value > completedValue)
+    if (value <= completedValue)
+        return true;
+
+    HANDLE eventHandle = getEventPool().acquire();
+    HRESULT hr = m_pFence->SetEventOnCompletion(value, eventHandle);
+    assert(SUCCEEDED(hr) && "Failed to set event on completion");
+
+    DWORD result = WaitForSingleObject(eventHandle, nTimeoutMs);
+    getEventPool().release(eventHandle, m_pFence.Get(), value);
+    return result == WAIT_OBJECT_0;
+}
+
+int D3D12Fence::waitManyImpl(std::span<const FenceTicket> tickets, bool bAll, uint32_t nTimeoutMs)
+{
+    // an event per ticket that has not landed yet
+    HANDLE eventHandles[MAXIMUM_WAIT_OBJECTS];
+    ID3D12Fence* pFences[MAXIMUM_WAIT_OBJECTS];
+    uint64_t values[MAXIMUM_WAIT_OBJECTS];
+    int ticketIndices[MAXIMUM_WAIT_OBJECTS];
+    DWORD nEvents = 0;
+    int iLanded = -1;
+    for (size_t u = 0; u < tickets.size(); ++u)
     {
-        // Create event for CPU waiting
-        HANDLE eventHandle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        assert(eventHandle != INVALID_HANDLE_VALUE && "Failed to create event");
-        
-        HRESULT hr = m_pFence->SetEventOnCompletion(value, eventHandle);
+        auto pD3D12Fence = dynamic_cast<D3D12Fence*>(tickets[u].m_pFence.get());
+        assert((pD3D12Fence || !tickets[u].m_pFence) && "Fences of different backends");
+        if (!pD3D12Fence || pD3D12Fence->getFence()->GetCompletedValue() >= tickets[u].m_value)
+        {
+            iLanded = int(u);
+            if (!bAll)
+                break;
+            continue;
+        }
+        assert(nEvents < MAXIMUM_WAIT_OBJECTS && "Too many fences to wait for");
+        pFences[nEvents] = pD3D12Fence->getFence();
+        values[nEvents] = tickets[u].m_value;
+        ticketIndices[nEvents] = int(u);
+        eventHandles[nEvents] = getEventPool().acquire();
+        HRESULT hr = pFences[nEvents]->SetEventOnCompletion(values[nEvents], eventHandles[nEvents]);
         assert(SUCCEEDED(hr) && "Failed to set event on completion");
-        
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
+        ++nEvents;
+    }
+
+    if (nEvents > 0 && (bAll || iLanded < 0))
+    {
+        DWORD result = WaitForMultipleObjects(nEvents, eventHandles, bAll ? TRUE : FALSE, nTimeoutMs);
+        if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + nEvents)
+        {
+            iLanded = ticketIndices[result - WAIT_OBJECT_0];
+        }
+        else
+        {
+            iLanded = -1;
+        }
     }
-}
\ No newline at end of file
+
+    // events of fences that have not landed yet are reused once they do
+    for (DWORD u = 0; u < nEvents; ++u)
+    {
+        getEventPool().release(eventHandles[u], pFences[u], values[u]);
+    }
+    return iLanded;
+}
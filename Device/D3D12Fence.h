@@ -3,6 +3,8 @@
 #include "IFence.h"
 #include <d3d12.h>
 #include <wrl/client.h>
+#include <mutex>
+#include <vector>
 
 using Microsoft::WRL::ComPtr;
 
@@ -11,16 +13,31 @@ class D3D12Queue;
 class D3D12Fence : public IFence
 {
 public:
-    D3D12Fence(ComPtr<ID3D12Fence> fence) : m_pFence(fence) {}
+    D3D12Fence(ComPtr<ID3D12Fence> fence);
     ID3D12Fence* getFence() const { return m_pFence.Get(); }
+    // the fence opened on another device - see D3D12Device::createSharedFence()
+    void addSharedFence(ComPtr<ID3D12Device> pDevice, ComPtr<ID3D12Fence> pFence);
 
 private:
+    struct SharedFence
+    {
+        ComPtr<ID3D12Device> m_pDevice;
+        ComPtr<ID3D12Fence> m_pFence;
+    };
+    // the fence object of the device that pQueue belongs to
+    ID3D12Fence* getFenceFor(IQueue* pQueue);
+
     // IFence interface implementation
     virtual void signalGpuFenceImpl(IQueue* pQueue, uint64_t value) override;
+    virtual void signalCpuFenceImpl(uint64_t value) override;
     virtual void waitGpuFenceImpl(IQueue* pQueue, uint64_t value) override;
     virtual uint64_t getLastLandedValueImpl() override;
-    virtual void waitCpuFenceImpl(uint64_t value) override;
+    virtual bool waitCpuFenceImpl(uint64_t value, uint32_t nTimeoutMs) override;
+    virtual int waitManyImpl(std::span<const FenceTicket> tickets, bool bAll, uint32_t nTimeoutMs) override;
 
     ComPtr<ID3D12Fence> m_pFence;
+    ComPtr<ID3D12Device> m_pDevice;
+    std::mutex m_sharedMutex;
+    std::vector<SharedFence> m_sharedFences;
 };
 
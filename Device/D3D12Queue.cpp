@@ -1,80 +1,264 @@
 #include "framework.h"
 #include "D3D12Queue.h"
 #include "D3D12CmdList.h"
+#include "D3D12Resource.h"
 #include <cassert>
 
-D3D12Queue::D3D12Queue(D3D12Device* pDevice, const std::wstring &sName)
+D3D12Queue::D3D12Queue(D3D12Device* pDevice, const std::wstring &sName, IDevice::eQueueType eType, uint32_t nAllocators)
+    : m_nAllocators(nAllocators)
 {
+    assert(nAllocators > 0 && "Queue needs at least one command allocator");
+
+    m_eType = eType;
+    switch (eType)
+    {
+    case IDevice::eQueueTypeDirect:
+        m_eListType = D3D12_COMMAND_LIST_TYPE_DIRECT;
+        break;
+    case IDevice::eQueueTypeCompute:
+        m_eListType = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        break;
+    case IDevice::eQueueTypeCopy:
+        m_eListType = D3D12_COMMAND_LIST_TYPE_COPY;
+        break;
+    default:
+        assert(false && "Unknown queue type");
+        break;
+    }
+
     D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    queueDesc.Type = m_eListType;
     queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
 
     HRESULT hr = pDevice->getDevice()->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_pQueue));
     assert(SUCCEEDED(hr) && "Failed to create command queue");
 
     // Set the name on the D3D12 command queue
+    setName(sName);
     if (!sName.empty())
     {
         m_pQueue->SetName(sName.c_str());
     }
 
-    // Create command allocators
-    hr = pDevice->getDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_pCurAlloc));
-    assert(SUCCEEDED(hr) && "Failed to create current command allocator");
-
-    hr = pDevice->getDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_pOtherAlloc));
-    assert(SUCCEEDED(hr) && "Failed to create other command allocator");
-
     // Create fence for allocator tracking
-    m_pAllocFence = pDevice->createFence();
-    assert(m_pAllocFence && "Failed to create allocator fence");
+    m_pFence = pDevice->createFence();
+    assert(m_pFence && "Failed to create allocator fence");
 
     m_pDevice = pDevice->shared_from_this();
+
+    createProfiler(pDevice);
+}
+
+void D3D12Queue::createProfiler(D3D12Device* pD3D12Device)
+{
+    ID3D12Device* pDevice = pD3D12Device->getDevice();
+    UINT64 nFrequency = 0;
+    if (FAILED(m_pQueue->GetTimestampFrequency(&nFrequency)) || nFrequency == 0)
+        return;  // scopes are not measured on this queue
+
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    if (m_eListType == D3D12_COMMAND_LIST_TYPE_COPY)
+    {
+        // timestamps on copy queues are an optional feature with a query heap of their own
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 options3 = {};
+        if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &options3, sizeof(options3))) ||
+            !options3.CopyQueueTimestampQueriesSupported)
+            return;
+        heapDesc.Type = D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP;
+    }
+    heapDesc.Count = Profiler::s_nMaxTimestamps;
+    HRESULT hr = pDevice->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&m_pQueryHeap));
+    assert(SUCCEEDED(hr) && "Failed to create timestamp query heap");
+
+    // the profiler reads only slots whose submission has landed, straight from the mapped buffer
+    IResource::ResDesc desc;
+    desc.m_format = IResource::eFormatUnknown;
+    desc.m_nDims = 1;
+    desc.m_res = { uint32_t(Profiler::s_nMaxTimestamps * sizeof(uint64_t)), 1, 1 };
+    desc.m_isReadback = true;
+    desc.m_isPersistentlyMapped = true;
+    m_pTimestampReadback = pD3D12Device->createResource(desc);
+    assert(m_pTimestampReadback && "Failed to create timestamp readback buffer");
+    const void* pTimestamps = m_pTimestampReadback->map();
+    m_pProfiler = std::make_unique<Profiler>(static_cast<const uint64_t*>(pTimestamps), nFrequency);
+}
+
+std::unique_ptr<IQueue::RecordingPool> D3D12Queue::createRecordingPool()
+{
+    auto pPool = std::make_unique<Pool>();
+    // command allocators are created on demand, up to nAllocators of them
+    pPool->m_allocators.reserve(m_nAllocators);
+    return pPool;
 }
 
-std::shared_ptr<ICmdList> D3D12Queue::startRecording()
+std::shared_ptr<ICmdList> D3D12Queue::startRecordingImpl(RecordingPool* pPool)
 {
-    // if the other alloc is not used anymore - we can make it current
-    if (m_pAllocFence->getLastLandedValue() >= m_otherAllocLastFenceValue)
+    // only the calling thread records from its pool - the lock is contended just by submissions of its lists
+    Pool& pool = *static_cast<Pool*>(pPool);
+    std::unique_lock<std::mutex> lock(pool.m_mutex);
+
+    // lists dropped without being executed are still open - close them and give their allocators back
+    for (auto& pCmdList : pool.m_pCmdLists)
     {
-        std::swap(m_pCurAlloc, m_pOtherAlloc);
-        m_pCurAlloc->Reset();
-        m_otherAllocLastFenceValue = m_pAllocFence->getLastSignalledValue();
+        if (pCmdList.use_count() == 1 && pCmdList->isRecording())
+        {
+            pCmdList->flushBarriers();
+            pCmdList->getCmdList()->Close();
+            pCmdList->setRecording(false);
+            releaseAllocator(pool, pCmdList->getAllocatorIndex(), 0);
+        }
     }
 
-    // Create new command list using m_pCurAlloc
-    ComPtr<ID3D12GraphicsCommandList> pCmdList;
-    HRESULT hr = static_cast<D3D12Device*>(m_pDevice.get())->getDevice()->CreateCommandList(
-        0,                          // node mask
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        m_pCurAlloc.Get(),          // command allocator
-        nullptr,                    // initial pipeline state
-        IID_PPV_ARGS(&pCmdList)
-    );
-    assert(SUCCEEDED(hr) && "Failed to create command list");
-
-    return std::make_shared<D3D12CmdList>(pCmdList);
+    uint32_t uAlloc = acquireAllocator(pool, lock);
+    ID3D12CommandAllocator* pAlloc = pool.m_allocators[uAlloc].m_pAlloc.Get();
+
+    // reuse a command list nobody holds anymore
+    std::shared_ptr<D3D12CmdList> pCmdList;
+    for (auto& pFree : pool.m_pCmdLists)
+    {
+        if (pFree.use_count() == 1)
+        {
+            pCmdList = pFree;
+            HRESULT hr = pCmdList->getCmdList()->Reset(pAlloc, nullptr);
+            assert(SUCCEEDED(hr) && "Failed to reset command list");
+            break;
+        }
+    }
+    if (!pCmdList)
+    {
+        ComPtr<ID3D12GraphicsCommandList> pD3D12CmdList;
+        HRESULT hr = static_cast<D3D12Device*>(m_pDevice.get())->getDevice()->CreateCommandList(
+            0,                          // node mask
+            m_eListType,
+            pAlloc,                     // command allocator
+            nullptr,                    // initial pipeline state
+            IID_PPV_ARGS(&pD3D12CmdList)
+        );
+        assert(SUCCEEDED(hr) && "Failed to create command list");
+        pCmdList = std::make_shared<D3D12CmdList>(pD3D12CmdList);
+        pool.m_pCmdLists.push_back(pCmdList);
+    }
+    pCmdList->setPool(&pool);
+    pCmdList->setAllocatorIndex(uAlloc);
+    pCmdList->setQueryHeap(m_pQueryHeap.Get());
+    pCmdList->beginRecording(m_pProfiler.get());
+    pCmdList->setRecording(true);
+    return pCmdList;
 }
 
-void D3D12Queue::execute(std::shared_ptr<ICmdList> pCmdList)
+uint32_t D3D12Queue::acquireAllocator(Pool& pool, std::unique_lock<std::mutex>& lock)
 {
-    assert(pCmdList && "Command list cannot be null");
-    D3D12CmdList* pD3D12CmdList = static_cast<D3D12CmdList*>(pCmdList.get());
+    auto& allocators = pool.m_allocators;
+    for ( ; ; )
+    {
+        // prefer an allocator whose commands have been executed already
+        uint64_t landedValue = m_pFence->getLastLandedValue();
+        uint32_t uOldest = UINT32_MAX;
+        for (uint32_t u = 0; u < allocators.size(); ++u)
+        {
+            const Allocator& alloc = allocators[u];
+            if (alloc.m_bRecording)
+                continue;
+            if (alloc.m_fenceValue <= landedValue)
+            {
+                uOldest = u;
+                break;
+            }
+            if (uOldest == UINT32_MAX || alloc.m_fenceValue < allocators[uOldest].m_fenceValue)
+            {
+                uOldest = u;
+            }
+        }
 
-    // Close the command list
-    HRESULT hr = pD3D12CmdList->getCmdList()->Close();
+        // a new allocator is created while the pool is not full, or when all of them are being recorded
+        if (uOldest == UINT32_MAX || (allocators.size() < m_nAllocators && allocators[uOldest].m_fenceValue > landedValue))
+        {
+            Allocator alloc;
+            HRESULT hr = static_cast<D3D12Device*>(m_pDevice.get())->getDevice()->CreateCommandAllocator(
+                m_eListType, IID_PPV_ARGS(&alloc.m_pAlloc));
+            assert(SUCCEEDED(hr) && "Failed to create command allocator");
+            alloc.m_bRecording = true;
+            allocators.push_back(alloc);
+            return uint32_t(allocators.size() - 1);
+        }
+
+        // the GPU is nAllocators submissions of this thread behind - wait for the oldest one. the pool is unlocked
+        // meanwhile, the wait may submit deferred lists of the pool
+        Allocator& alloc = allocators[uOldest];
+        if (alloc.m_fenceValue > landedValue)
+        {
+            uint64_t waitValue = alloc.m_fenceValue;
+            lock.unlock();
+            m_pFence->waitCpuFence(waitValue);
+            lock.lock();
+            continue;
+        }
+        HRESULT hr = alloc.m_pAlloc->Reset();
+        assert(SUCCEEDED(hr) && "Failed to reset command allocator");
+        alloc.m_bRecording = true;
+        return uOldest;
+    }
+}
+
+void D3D12Queue::releaseAllocator(Pool& pool, uint32_t uAlloc, uint64_t fenceValue)
+{
+    assert(pool.m_allocators[uAlloc].m_bRecording && "Allocator is not being recorded");
+    pool.m_allocators[uAlloc].m_fenceValue = fenceValue;
+    pool.m_allocators[uAlloc].m_bRecording = false;
+}
+
+void D3D12Queue::closeCmdList(D3D12CmdList* pCmdList, uint64_t fenceValue)
+{
+    // transitions still pending and the timestamp resolve are recorded first
+    pCmdList->flushBarriers();
+    if (m_pTimestampReadback)
+    {
+        pCmdList->resolveTimestamps(static_cast<D3D12Resource*>(m_pTimestampReadback.get())->getResource());
+    }
+    HRESULT hr = pCmdList->getCmdList()->Close();
     assert(SUCCEEDED(hr) && "Failed to close command list");
 
-    // Execute the command list
-    ID3D12CommandList* ppCommandLists[] = { pD3D12CmdList->getCmdList() };
-    m_pQueue->ExecuteCommandLists(1, ppCommandLists);
+    // the lists may come from the pools of several recording threads
+    Pool& pool = *static_cast<Pool*>(pCmdList->getPool());
+    std::lock_guard<std::mutex> lock(pool.m_mutex);
+    pCmdList->setRecording(false);
+    releaseAllocator(pool, pCmdList->getAllocatorIndex(), fenceValue);
+}
 
-    // Signal the fence to track this command list's completion
-    m_pAllocFence->signalGpuFence(this, m_pAllocFence->getLastSignalledValue() + 1);
+void D3D12Queue::deferImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue)
+{
+    for (auto& pCmdList : pCmdLists)
+    {
+        assert(pCmdList && "Command list cannot be null");
+        closeCmdList(static_cast<D3D12CmdList*>(pCmdList.get()), fenceValue);
+    }
+}
+
+void D3D12Queue::executeImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue)
+{
+    m_pSubmitLists.clear();
+    for (auto& pCmdList : pCmdLists)
+    {
+        assert(pCmdList && "Command list cannot be null");
+        D3D12CmdList* pD3D12CmdList = static_cast<D3D12CmdList*>(pCmdList.get());
+        // deferred lists were closed by execute() already
+        if (pD3D12CmdList->isRecording())
+        {
+            closeCmdList(pD3D12CmdList, fenceValue);
+        }
+        m_pSubmitLists.push_back(pD3D12CmdList->getCmdList());
+    }
+
+    // Execute all command lists in one go
+    if (!m_pSubmitLists.empty())
+    {
+        m_pQueue->ExecuteCommandLists(UINT(m_pSubmitLists.size()), m_pSubmitLists.data());
+    }
 }
 
 void D3D12Queue::flush()
 {
     // Wait for all GPU work to complete by waiting for the fence
-    m_pAllocFence->waitCpuFence(m_pAllocFence->getLastSignalledValue());
-} 
\ No newline at end of file
+    m_pFence->waitCpuFence(m_pFence->getLastSignalledValue());
+}
@@ -5,23 +5,57 @@
 #include <d3d12.h>
 #include <wrl/client.h>
 #include <memory>
+#include <vector>
+#include <mutex>
 
 using Microsoft::WRL::ComPtr;
 
+class D3D12CmdList;
+
 class D3D12Queue : public IQueue
 {
 public:
-    D3D12Queue(D3D12Device* pDevice, const std::wstring &sName);
-    virtual std::shared_ptr<ICmdList> startRecording() override;
-    virtual void execute(std::shared_ptr<ICmdList> pCmdList) override;
+    D3D12Queue(D3D12Device* pDevice, const std::wstring &sName, IDevice::eQueueType eType, uint32_t nAllocators);
     virtual void flush() override;
 
     ID3D12CommandQueue* getQueue12() const { return m_pQueue.Get(); }
 
 private:
+    struct Allocator
+    {
+        ComPtr<ID3D12CommandAllocator> m_pAlloc;
+        // the allocator can be reset once m_pFence reaches this value
+        uint64_t m_fenceValue = 0;
+        bool m_bRecording = false;
+    };
+    // allocators and command lists of one recording thread, guarded by m_mutex
+    struct Pool : public RecordingPool
+    {
+        std::vector<Allocator> m_allocators;
+        // command lists can be reset as soon as they were submitted, but not while the caller still holds them
+        std::vector<std::shared_ptr<D3D12CmdList>> m_pCmdLists;
+    };
+
+    virtual void executeImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue) override;
+    virtual void deferImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue) override;
+    virtual std::shared_ptr<ICmdList> startRecordingImpl(RecordingPool* pPool) override;
+    virtual std::unique_ptr<RecordingPool> createRecordingPool() override;
+
+    void createProfiler(D3D12Device* pDevice);
+    // the pool is unlocked while waiting for an allocator
+    uint32_t acquireAllocator(Pool& pool, std::unique_lock<std::mutex>& lock);
+    // closes the list and hands its allocator over, it can be reset once m_pFence reaches fenceValue
+    void closeCmdList(D3D12CmdList* pCmdList, uint64_t fenceValue);
+    static void releaseAllocator(Pool& pool, uint32_t uAlloc, uint64_t fenceValue);
+
     ComPtr<ID3D12CommandQueue> m_pQueue;
-    ComPtr<ID3D12CommandAllocator> m_pCurAlloc;
-    ComPtr<ID3D12CommandAllocator> m_pOtherAlloc;
-    std::shared_ptr<IFence> m_pAllocFence;
-    uint64_t m_otherAllocLastFenceValue = 0;
+    // of the queue, its allocators and its command lists
+    D3D12_COMMAND_LIST_TYPE m_eListType = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    // timestamps of m_pProfiler, the readback buffer stays mapped
+    ComPtr<ID3D12QueryHeap> m_pQueryHeap;
+    std::shared_ptr<IResource> m_pTimestampReadback;
+    // per recording thread
+    uint32_t m_nAllocators = 0;
+    // scratch array for ExecuteCommandLists, guarded by m_submitMutex
+    std::vector<ID3D12CommandList*> m_pSubmitLists;
 }; 
\ No newline at end of file
@@ -1,62 +1,25 @@
 #include "framework.h"
 #include "D3D12Resource.h"
-#include "D3D12Queue.h"
 #include "IResource.h"
 #include <cassert>
-#define STB_IMAGE_IMPLEMENTATION
-#include "external/stb/stb_image.h"
 
-D3D12Resource::D3D12Resource(ComPtr<ID3D12Resource> resource)
+D3D12Resource::D3D12Resource(ComPtr<ID3D12Resource> resource, bool bPersistentlyMapped)
     : m_resource(resource)
 {
+    if (bPersistentlyMapped)
+    {
+        HRESULT hr = m_resource->Map(0, nullptr, &m_pMappedData);
+        assert(SUCCEEDED(hr) && "Failed to map resource");
+        (void)hr;
+    }
 }
 
-void D3D12Resource::loadFromFile(const std::filesystem::path& sPath, IQueue* pQueue)
+D3D12Resource::~D3D12Resource()
 {
-    // Load image using STB Image
-    int width, height, channels;
-    unsigned char* imageData = stbi_load(sPath.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
-    if (!imageData)
+    if (m_pMappedData)
     {
-        assert(false && "Failed to load image");
-        return;
+        m_resource->Unmap(0, nullptr);
     }
-
-    // Create staging buffer using IDevice interface
-    IResource::ResDesc stagingDesc;
-    stagingDesc.m_format = IResource::eFormatUnknown;  // Use unknown format for staging buffer
-    stagingDesc.m_nDims = 1;  // Buffer
-    stagingDesc.m_res[0] = width * height * 4;  // RGBA format
-    stagingDesc.m_res[1] = 1;
-    stagingDesc.m_res[2] = 1;
-    stagingDesc.m_isStaging = true;  // Mark as staging resource
-
-    IDevice* pDevice = pQueue->getDevice();
-    auto pStagingResource = pDevice->createResource(stagingDesc);
-    assert(pStagingResource && "Failed to create staging resource");
-
-    pStagingResource->writeTo((const char *)imageData, width * height * 4);
-
-    // Free the loaded image data
-    stbi_image_free(imageData);
-
-    // Get command list from queue
-    auto pCmdList = pQueue->startRecording();
-    assert(pCmdList && "Failed to get command list from queue");
-
-    // Transition resource to copy destination using ICmdList interface
-    pCmdList->barrier(this, eBarrierStateCommon, eBarrierStateCopyDst);
-
-    // Copy data from staging buffer to resource using ICmdList interface
-    pCmdList->copyFromStaging(this, pStagingResource.get(), width * 4);
-
-    // Transition resource back to common state using ICmdList interface
-    pCmdList->barrier(this, eBarrierStateCopyDst, eBarrierStateCommon);
-
-    // Execute command list
-    pQueue->execute(pCmdList);
-
-    pQueue->flush();
 }
 
 void D3D12Resource::getDesc(IResource::ResDesc& outDesc)
@@ -69,6 +32,15 @@ void D3D12Resource::getDesc(IResource::ResDesc& outDesc)
     case DXGI_FORMAT_R8G8B8A8_UNORM:
         outDesc.m_format = IResource::eFormatRGBA8;
         break;
+    case DXGI_FORMAT_BC1_UNORM:
+        outDesc.m_format = IResource::eFormatBC1;
+        break;
+    case DXGI_FORMAT_BC3_UNORM:
+        outDesc.m_format = IResource::eFormatBC3;
+        break;
+    case DXGI_FORMAT_BC7_UNORM:
+        outDesc.m_format = IResource::eFormatBC7;
+        break;
     case DXGI_FORMAT_UNKNOWN:
         outDesc.m_format = IResource::eFormatUnknown;
         break;
@@ -86,6 +58,15 @@ void D3D12Resource::getDesc(IResource::ResDesc& outDesc)
     outDesc.m_res[0] = static_cast<uint32_t>(d3dDesc.Width);
     outDesc.m_res[1] = d3dDesc.Height;
     outDesc.m_res[2] = d3dDesc.DepthOrArraySize;
+    outDesc.m_nMips = d3dDesc.MipLevels;
+
+    // Set flags
+    D3D12_HEAP_PROPERTIES heapProps = {};
+    bool bHeapProps = SUCCEEDED(m_resource->GetHeapProperties(&heapProps, nullptr));
+    outDesc.m_isStaging = bHeapProps && heapProps.Type == D3D12_HEAP_TYPE_UPLOAD;
+    outDesc.m_isReadback = bHeapProps && heapProps.Type == D3D12_HEAP_TYPE_READBACK;
+    outDesc.m_isShared = (d3dDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER) != 0;
+    outDesc.m_isPersistentlyMapped = m_pMappedData != nullptr;
 }
 
 void D3D12Resource::writeTo(const char* pData, uint32_t nBytes)
@@ -103,18 +84,31 @@ void D3D12Resource::writeTo(const char* pData, uint32_t nBytes)
         return;
     }
 
-    // Map the resource
-    void* mappedData = nullptr;
-    HRESULT hr = m_resource->Map(0, nullptr, &mappedData);
+    // persistently mapped resources only cost the memcpy
+    void* pMappedData = map();
+    if (!pMappedData)
+        return;
+    memcpy(pMappedData, pData, nBytes);
+    unmap();
+}
+
+void* D3D12Resource::map()
+{
+    if (m_pMappedData)
+        return m_pMappedData;
+    void* pMappedData = nullptr;
+    HRESULT hr = m_resource->Map(0, nullptr, &pMappedData);
     if (FAILED(hr))
     {
-        assert(false && "Failed to map resource for writing");
-        return;
+        assert(false && "Failed to map resource");
+        return nullptr;
     }
+    return pMappedData;
+}
 
-    // Copy all data
-    memcpy(mappedData, pData, nBytes);
-
-    // Unmap the resource
+void D3D12Resource::unmap()
+{
+    if (m_pMappedData)
+        return;
     m_resource->Unmap(0, nullptr);
 }
@@ -10,12 +10,15 @@ using Microsoft::WRL::ComPtr;
 class D3D12Resource : public IResource
 {
 public:
-    D3D12Resource(ComPtr<ID3D12Resource> resource);
+    // bPersistentlyMapped: the resource is mapped for its whole lifetime (see ResDesc::m_isPersistentlyMapped)
+    D3D12Resource(ComPtr<ID3D12Resource> resource, bool bPersistentlyMapped = false);
+    ~D3D12Resource();
 
     // IResource interface
-    virtual void loadFromFile(const std::filesystem::path& sPath, IQueue* pQueue) override;
     virtual void getDesc(ResDesc& outDesc) override;
     virtual void writeTo(const char* pData, uint32_t nBytes) override;
+    virtual void* map() override;
+    virtual void unmap() override;
 
     // Getter for the underlying D3D12 resource
     ID3D12Resource* getResource() const { return m_resource.Get(); }
@@ -29,4 +32,6 @@ public:
 
 private:
     ComPtr<ID3D12Resource> m_resource;
+    // set for persistently mapped resources
+    void* m_pMappedData = nullptr;
 }; 
\ No newline at end of file
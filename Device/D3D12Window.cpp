@@ -57,7 +57,8 @@ std::shared_ptr<IWindow> D3D12Window::create(D3D12Device* pDevice, uint32_t nSwa
     swapChainDesc.SampleDesc.Quality = 0;
     swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     swapChainDesc.BufferCount = nSwapChainImages;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    // the images keep their contents between presents, so the game copies only the regions that changed
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
     swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH | DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
 
     auto pQueue = pDevice->createQueue(L"PresentQueue");
@@ -0,0 +1,294 @@
+#include "framework.h"
+#include "DecodeService.h"
+#include "TextureCache.h"
+#include "BlockCodec.h"
+#include "MipChain.h"
+#include "PixelKernels.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "external/stb/stb_image.h"
+
+namespace {
+    // RGBA8 copy of the image (and its mips) on the way to a block-compressed format. every decoding thread
+    // keeps its own, so it is reallocated only when an image is larger than all before it
+    std::vector<uint8_t>& getScratch()
+    {
+        thread_local std::vector<uint8_t> scratch;
+        return scratch;
+    }
+}
+
+bool DecodedImage::decode(const std::filesystem::path& sPath, IResource::eFormat format, uint32_t nMips, ThreadPool* pThreadPool)
+{
+    m_format = format;
+    // previously decoded (and encoded) pixels are only a copy away
+    TextureCache::MappedImage cache;
+    if (cache.open(sPath))
+    {
+        const auto& header = cache.getHeader();
+        uint32_t nCachedMips = std::min(nMips, MipChain::getFullCount(header.m_nWidth, header.m_nHeight));
+        if (header.m_format == uint32_t(format) && header.m_nMips == nCachedMips)
+        {
+            m_nWidth = header.m_nWidth;
+            m_nHeight = header.m_nHeight;
+            m_nMips = nCachedMips;
+            uint32_t nRowBytes = IResource::getPackedRowPitch(format, m_nWidth);
+            uint32_t nRows = IResource::getBlockRows(format, m_nHeight);
+            m_pixels.resize(MipChain::getLevelOffset(format, m_nWidth, m_nHeight, m_nMips));
+            if (header.m_nRowPitch == nRowBytes)
+            {
+                memcpy(m_pixels.data(), cache.getPixels(), m_pixels.size());
+                return true;
+            }
+            for (uint32_t uRow = 0; uRow < nRows; ++uRow)
+            {
+                memcpy(m_pixels.data() + size_t(uRow) * nRowBytes, cache.getPixels() + size_t(uRow) * header.m_nRowPitch, nRowBytes);
+            }
+            return true;
+        }
+    }
+
+    int width, height, channels;
+    unsigned char* imageData = stbi_load(sPath.string().c_str(), &width, &height, &channels, 0);
+    if (!imageData)
+    {
+        return false;
+    }
+    m_nWidth = uint32_t(width);
+    m_nHeight = uint32_t(height);
+    convert(sPath, imageData, uint32_t(channels), format, nMips, pThreadPool);
+    stbi_image_free(imageData);
+    return true;
+}
+
+void DecodedImage::convert(const std::filesystem::path& sPath, const uint8_t* pImage, uint32_t nChannels,
+    IResource::eFormat format, uint32_t nMips, ThreadPool* pThreadPool)
+{
+    m_format = format;
+    m_nMips = std::min(nMips, MipChain::getFullCount(m_nWidth, m_nHeight));
+    size_t nPixels = size_t(m_nWidth) * m_nHeight;
+    // stb hands out the file in its own channels - the expansion to RGBA8 and the move into the recycled
+    // buffers are one pass
+    auto copyLevel0 = [&](uint8_t* pDst)
+    {
+        PixelKernels::expandToRGBA(pImage, nChannels, pDst, nPixels);
+    };
+    m_pixels.resize(MipChain::getLevelOffset(format, m_nWidth, m_nHeight, m_nMips));
+    if (IResource::getBlockSize(format) > 1)
+    {
+        // the mips are filtered in RGBA8, then every level is encoded. RGBA images without mips are encoded as they are
+        const uint8_t* pChain = pImage;
+        if (m_nMips > 1 || nChannels != 4)
+        {
+            std::vector<uint8_t>& scratch = getScratch();
+            scratch.resize(MipChain::getLevelOffset(IResource::eFormatRGBA8, m_nWidth, m_nHeight, m_nMips));
+            copyLevel0(scratch.data());
+            TRACE_ZONE("mips");
+            MipChain::generate(scratch.data(), m_nWidth, m_nHeight, m_nMips, pThreadPool);
+            pChain = scratch.data();
+        }
+        TRACE_ZONE("encode");
+        for (uint32_t uMip = 0; uMip < m_nMips; ++uMip)
+        {
+            uint32_t nLevelWidth = MipChain::getLevelSize(m_nWidth, uMip), nLevelHeight = MipChain::getLevelSize(m_nHeight, uMip);
+            BlockCodec::encode(format, pChain + MipChain::getLevelOffset(IResource::eFormatRGBA8, m_nWidth, m_nHeight, uMip),
+                nLevelWidth, nLevelHeight, nLevelWidth * 4, m_pixels.data() + MipChain::getLevelOffset(format, m_nWidth, m_nHeight, uMip),
+                IResource::getPackedRowPitch(format, nLevelWidth), pThreadPool);
+        }
+    }
+    else
+    {
+        copyLevel0(m_pixels.data());
+        if (m_nMips > 1)
+        {
+            TRACE_ZONE("mips");
+            MipChain::generate(m_pixels.data(), m_nWidth, m_nHeight, m_nMips, pThreadPool);
+        }
+    }
+
+    TextureCache::write(sPath, m_nWidth, m_nHeight, format, IResource::getPackedRowPitch(format, m_nWidth), m_pixels.data(), m_nMips);
+}
+
+bool DecodedImage::decodeInto(const std::filesystem::path& sPath, IResource::eFormat format, const DstFunc& getDst, ThreadPool* pThreadPool)
+{
+    TextureCache::MappedImage cache;
+    // the top level of a cached mip chain works as well
+    if (cache.open(sPath) && cache.getHeader().m_format == uint32_t(format))
+    {
+        m_format = format;
+        m_nWidth = cache.getHeader().m_nWidth;
+        m_nHeight = cache.getHeader().m_nHeight;
+        m_nMips = 1;
+        copyRows(cache.getPixels(), cache.getHeader().m_nRowPitch, getDst);
+        return true;
+    }
+
+    int width, height, channels;
+    unsigned char* imageData = stbi_load(sPath.string().c_str(), &width, &height, &channels, 0);
+    if (!imageData)
+        return false;
+    m_nWidth = uint32_t(width);
+    m_nHeight = uint32_t(height);
+    if (format == IResource::eFormatRGBA8 && channels == 4)
+    {
+        // RGBA images need no conversion - the rows go from the decoder to the destination and the cache
+        m_format = format;
+        m_nMips = 1;
+        copyRows(imageData, m_nWidth * 4, getDst);
+        TextureCache::write(sPath, m_nWidth, m_nHeight, format, m_nWidth * 4, imageData);
+    }
+    else
+    {
+        convert(sPath, imageData, uint32_t(channels), format, 1, pThreadPool);
+        copyRows(m_pixels.data(), IResource::getPackedRowPitch(format, m_nWidth), getDst);
+    }
+    stbi_image_free(imageData);
+    return true;
+}
+
+void DecodedImage::copyRows(const uint8_t* pSrc, uint32_t nSrcRowPitch, const DstFunc& getDst) const
+{
+    uint32_t nDstRowPitch = 0;
+    uint8_t* pDst = getDst(m_nWidth, m_nHeight, nDstRowPitch);
+    uint32_t nRowBytes = IResource::getPackedRowPitch(m_format, m_nWidth);
+    uint32_t nRows = IResource::getBlockRows(m_format, m_nHeight);
+    assert(nDstRowPitch >= nRowBytes && "Destination rows are too short");
+    if (nDstRowPitch == nSrcRowPitch)
+    {
+        memcpy(pDst, pSrc, size_t(nRows - 1) * nSrcRowPitch + nRowBytes);
+        return;
+    }
+    for (uint32_t uRow = 0; uRow < nRows; ++uRow)
+    {
+        memcpy(pDst + size_t(uRow) * nDstRowPitch, pSrc + size_t(uRow) * nSrcRowPitch, nRowBytes);
+    }
+}
+
+DecodeService::DecodeService(uint32_t nThreads, uint32_t nMaxImages, IResource::eFormat format, uint32_t nMips)
+    : m_pState(std::make_shared<State>())
+    , m_format(format)
+    , m_nMips(nMips)
+    , m_threadPool(nThreads)
+{
+    assert(nMaxImages > 0);
+    for (uint32_t u = 0; u < nMaxImages; ++u)
+    {
+        m_pState->m_slots.push_back(std::make_unique<Slot>());
+        m_pState->m_pFreeSlots.push_back(m_pState->m_slots.back().get());
+    }
+}
+
+DecodeService::~DecodeService()
+{
+    m_threadPool.waitIdle();
+}
+
+void DecodeService::prefetch(const std::filesystem::path& sPath)
+{
+    prefetch(sPath, true);
+}
+
+bool DecodeService::tryPrefetch(const std::filesystem::path& sPath)
+{
+    return prefetch(sPath, false);
+}
+
+bool DecodeService::prefetch(const std::filesystem::path& sPath, bool bBlock)
+{
+    Slot* pSlot = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_pState->m_mutex);
+        auto& requested = m_pState->m_pRequested;
+        if (std::any_of(requested.begin(), requested.end(), [&](Slot* p) { return p->m_sPath == sPath; }))
+            return true;
+
+        for ( ; ; )
+        {
+            // prefetched images that were never acquired are dropped first, oldest first
+            if (m_pState->m_pFreeSlots.empty())
+            {
+                auto it = std::find_if(requested.begin(), requested.end(), [](Slot* p) { return p->m_bDone; });
+                if (it != requested.end())
+                {
+                    m_pState->m_pFreeSlots.push_back(*it);
+                    requested.erase(it);
+                }
+            }
+            if (!m_pState->m_pFreeSlots.empty())
+                break;
+            // backpressure: wait until a decode finishes or the consumer releases one of the images
+            if (!bBlock)
+                return false;
+            m_pState->m_cv.wait(lock);
+        }
+        pSlot = m_pState->m_pFreeSlots.back();
+        m_pState->m_pFreeSlots.pop_back();
+        pSlot->m_sPath = sPath;
+        pSlot->m_bDone = false;
+        requested.push_back(pSlot);
+    }
+
+    auto pState = m_pState;
+    // the pool outlives its tasks - the destructor waits for them
+    m_threadPool.submit([pState, pSlot, format = m_format, nMips = m_nMips, pThreadPool = &m_threadPool]()
+    {
+        bool bSucceeded = false;
+        {
+            TRACE_ZONE("decode");
+            bSucceeded = pSlot->m_image.decode(pSlot->m_sPath, format, nMips, pThreadPool);
+        }
+        {
+            std::lock_guard<std::mutex> lock(pState->m_mutex);
+            pSlot->m_bSucceeded = bSucceeded;
+            pSlot->m_bDone = true;
+        }
+        pState->m_cv.notify_all();
+    });
+    return true;
+}
+
+std::shared_ptr<const DecodedImage> DecodeService::acquire(const std::filesystem::path& sPath)
+{
+    Slot* pSlot = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_pState->m_mutex);
+        auto& requested = m_pState->m_pRequested;
+        for ( ; ; )
+        {
+            auto it = std::find_if(requested.begin(), requested.end(), [&](Slot* p) { return p->m_sPath == sPath; });
+            if (it != requested.end())
+            {
+                pSlot = *it;
+                requested.erase(it);
+                break;
+            }
+            lock.unlock();
+            prefetch(sPath, true);
+            lock.lock();
+        }
+        m_pState->m_cv.wait(lock, [pSlot]() { return pSlot->m_bDone; });
+    }
+
+    if (!pSlot->m_bSucceeded)
+    {
+        m_pState->recycle(pSlot);
+        return nullptr;
+    }
+
+    auto pState = m_pState;
+    return std::shared_ptr<const DecodedImage>(&pSlot->m_image, [pState, pSlot](const DecodedImage*)
+    {
+        pState->recycle(pSlot);
+    });
+}
+
+void DecodeService::State::recycle(Slot* pSlot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pFreeSlots.push_back(pSlot);
+    }
+    m_cv.notify_all();
+}
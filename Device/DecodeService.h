@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "IResource.h"
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// RGBA8 or block-compressed image, rows (of blocks) are tightly packed. with m_nMips > 1 m_pixels is a mip chain
+// laid out by MipChain
+struct DecodedImage
+{
+    uint32_t m_nWidth = 0, m_nHeight = 0;
+    uint32_t m_nMips = 1;
+    IResource::eFormat m_format = IResource::eFormatRGBA8;
+    std::vector<uint8_t> m_pixels;
+
+    // decodes the file into the image, reusing the capacity of m_pixels. stb allocates the decoded file on every
+    // call, it is moved into m_pixels in the pass that expands it to RGBA8. up to nMips mips are generated and
+    // block-compressed formats get encoded after that, spread over the threads of pThreadPool if there is one
+    bool decode(const std::filesystem::path& sPath, IResource::eFormat format = IResource::eFormatRGBA8,
+        uint32_t nMips = 1, ThreadPool* pThreadPool = nullptr);
+
+    // where decodeInto() puts the rows of an image of the given size, and their pitch
+    typedef std::function<uint8_t*(uint32_t nWidth, uint32_t nHeight, uint32_t& outRowPitch)> DstFunc;
+    // decodes the top level straight into the memory getDst returns, e.g. the upload ring at the pitch of
+    // IResource::getUploadFootprints(). pixels from a valid TextureCache or RGBA images are copied there once.
+    // pixels that need a conversion pass m_pixels, which the cache is written from - the destination may be
+    // write-combined memory that is slow to read
+    bool decodeInto(const std::filesystem::path& sPath, IResource::eFormat format, const DstFunc& getDst,
+        ThreadPool* pThreadPool = nullptr);
+
+private:
+    // turns the pixels stb decoded (nChannels per pixel, m_nWidth x m_nHeight) into m_pixels and writes the cache
+    void convert(const std::filesystem::path& sPath, const uint8_t* pImage, uint32_t nChannels, IResource::eFormat format,
+        uint32_t nMips, ThreadPool* pThreadPool);
+    // copies the rows of the top level to the memory getDst returns
+    void copyRows(const uint8_t* pSrc, uint32_t nSrcRowPitch, const DstFunc& getDst) const;
+};
+
+// decodes images ahead of use on a thread pool. the number of images that are decoded, waiting to be
+// acquired or held by the caller is bounded by nMaxImages - their pixel buffers (not stb's) are recycled. when all
+// of them are in use, the oldest decoded image that was not acquired yet is dropped. images are delivered in
+// the given format and with up to nMips mips - generated and encoded on the same threads
+class DecodeService
+{
+public:
+    DecodeService(uint32_t nThreads, uint32_t nMaxImages, IResource::eFormat format = IResource::eFormatRGBA8,
+        uint32_t nMips = 1);
+    ~DecodeService();
+
+    // starts decoding the file in the background. blocks while all nMaxImages images are being decoded
+    // or held by the caller
+    void prefetch(const std::filesystem::path& sPath);
+    // same as prefetch() but returns false instead of blocking
+    bool tryPrefetch(const std::filesystem::path& sPath);
+    // returns the decoded image (prefetching it first if needed) or null if decoding failed.
+    // the image goes back to the service when the returned pointer is released
+    std::shared_ptr<const DecodedImage> acquire(const std::filesystem::path& sPath);
+
+private:
+    struct Slot
+    {
+        std::filesystem::path m_sPath;
+        DecodedImage m_image;
+        bool m_bDone = false, m_bSucceeded = false;
+    };
+    // shared with the decode tasks and with the deleters of acquired images
+    struct State
+    {
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<std::unique_ptr<Slot>> m_slots;
+        std::vector<Slot*> m_pFreeSlots;
+        // prefetched but not acquired yet
+        std::vector<Slot*> m_pRequested;
+
+        void recycle(Slot* pSlot);
+    };
+    bool prefetch(const std::filesystem::path& sPath, bool bBlock);
+
+    std::shared_ptr<State> m_pState;
+    IResource::eFormat m_format;
+    uint32_t m_nMips;
+    ThreadPool m_threadPool;
+};
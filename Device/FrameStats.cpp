@@ -0,0 +1,15 @@
+#include "framework.h"
+#include "FrameStats.h"
+#include <algorithm>
+#include <cmath>
+
+double FrameStats::getPercentile(const std::vector<float>& samples, double p)
+{
+    if (samples.empty())
+        return 0;
+    std::vector<float> sorted = samples;
+    size_t uRank = size_t(std::ceil(std::clamp(p, 0.0, 100.0) / 100 * sorted.size()));
+    size_t uIndex = std::max<size_t>(uRank, 1) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + uIndex, sorted.end());
+    return sorted[uIndex];
+}
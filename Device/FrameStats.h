@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+
+// statistics of frame timings, shared by HeadlessWindow and the timeline of the game
+struct FrameStats
+{
+    // nearest-rank percentile: the smallest sample that at least p percent of the samples are not above. 0 without samples
+    static double getPercentile(const std::vector<float>& samples, double p);
+    static float toMs(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+};
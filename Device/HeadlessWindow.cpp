@@ -0,0 +1,121 @@
+#include "framework.h"
+#include "HeadlessWindow.h"
+#include "IResource.h"
+#include "FrameStats.h"
+#include <algorithm>
+#include <thread>
+#include <cassert>
+#include <cstdio>
+
+std::shared_ptr<HeadlessWindow> HeadlessWindow::create(IDevice* pDevice, uint32_t nSwapChainImages, uint2 vRes,
+    double fPresentIntervalMs, uint32_t nMaxFrames)
+{
+    assert(nSwapChainImages > 0 && "Need at least one image");
+
+    auto window = std::make_shared<HeadlessWindow>();
+    window->m_pDevice = pDevice->shared_from_this();
+    window->m_pQueue = pDevice->createQueue(L"PresentQueue");
+    window->m_pPresentFence = pDevice->createFence();
+    if (!window->m_pQueue || !window->m_pPresentFence)
+    {
+        return nullptr;
+    }
+
+    IResource::ResDesc desc;
+    desc.m_format = IResource::eFormatRGBA8;
+    desc.m_nDims = 2;
+    desc.m_res[0] = vRes.x;
+    desc.m_res[1] = vRes.y;
+    desc.m_res[2] = 1;
+    for (uint32_t u = 0; u < nSwapChainImages; ++u)
+    {
+        auto pImage = pDevice->createResource(desc);
+        if (!pImage)
+        {
+            return nullptr;
+        }
+#ifndef NDEBUG
+        pImage->setName(L"backbuffer");
+#endif
+        window->m_pImages.push_back(pImage);
+    }
+    window->m_imageFenceValues.resize(nSwapChainImages, 0);
+
+    window->m_presentInterval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(fPresentIntervalMs));
+    window->m_nMaxFrames = nMaxFrames;
+    window->m_nMaxSamples = nMaxFrames > 0 ? nMaxFrames : s_nMaxSamples;
+    window->m_frameTimesMs.reserve(window->m_nMaxSamples);
+    window->m_frameLatenciesMs.reserve(window->m_nMaxSamples);
+    window->m_lastPresentTime = Clock::now();
+
+    return window;
+}
+
+std::shared_ptr<IResource> HeadlessWindow::getNextImage()
+{
+    // same throttling as a flip swap chain: the image can be handed out again once its previous present went through
+    m_currentImageIndex = m_nPresentedFrames % m_pImages.size();
+    m_pPresentFence->waitCpuFence(m_imageFenceValues[m_currentImageIndex]);
+
+    m_nextImageTime = Clock::now();
+    return m_pImages[m_currentImageIndex];
+}
+
+void HeadlessWindow::present()
+{
+    // the image is "displayed" once the queue has finished everything submitted before the present
+    uint64_t fenceValue = m_pPresentFence->getLastSignalledValue() + 1;
+    m_pPresentFence->signalGpuFence(m_pQueue.get(), fenceValue);
+    m_imageFenceValues[m_currentImageIndex] = fenceValue;
+
+    // simulated vsync: wait for the next vblank after the previous present
+    Clock::time_point now = Clock::now();
+    if (m_presentInterval.count() > 0)
+    {
+        Clock::time_point vblank = m_lastPresentTime + m_presentInterval;
+        if (now < vblank)
+        {
+            std::this_thread::sleep_until(vblank);
+            now = Clock::now();
+        }
+    }
+
+    // running forever keeps the last m_nMaxSamples frames
+    if (m_frameTimesMs.size() < m_nMaxSamples)
+    {
+        m_frameTimesMs.push_back(FrameStats::toMs(now - m_lastPresentTime));
+        m_frameLatenciesMs.push_back(FrameStats::toMs(now - m_nextImageTime));
+    }
+    else
+    {
+        m_frameTimesMs[m_nPresentedFrames % m_nMaxSamples] = FrameStats::toMs(now - m_lastPresentTime);
+        m_frameLatenciesMs[m_nPresentedFrames % m_nMaxSamples] = FrameStats::toMs(now - m_nextImageTime);
+    }
+    m_lastPresentTime = now;
+    ++m_nPresentedFrames;
+}
+
+bool HeadlessWindow::pollEvents()
+{
+    return m_nMaxFrames == 0 || m_nPresentedFrames < m_nMaxFrames;
+}
+
+double HeadlessWindow::getFrameTimePercentile(double p) const
+{
+    return FrameStats::getPercentile(m_frameTimesMs, p);
+}
+
+double HeadlessWindow::getFrameLatencyPercentile(double p) const
+{
+    return FrameStats::getPercentile(m_frameLatenciesMs, p);
+}
+
+void HeadlessWindow::printStats() const
+{
+    printf("Presented %u frames\n", m_nPresentedFrames);
+    printf("Frame time    (ms): p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+        getFrameTimePercentile(50), getFrameTimePercentile(90), getFrameTimePercentile(99), getFrameTimePercentile(100));
+    printf("Frame latency (ms): p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+        getFrameLatencyPercentile(50), getFrameLatencyPercentile(90), getFrameLatencyPercentile(99), getFrameLatencyPercentile(100));
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "IWindow.h"
+#include "math/vector.h"
+#include <vector>
+#include <chrono>
+
+// offscreen "swap chain" for benchmarking without a display. works with any IDevice: the images are
+// regular textures of that device and present() only paces the loop and collects frame statistics
+class HeadlessWindow : public IWindow
+{
+public:
+    // fPresentIntervalMs simulates vsync (0 - present immediately), nMaxFrames makes pollEvents()
+    // return false after that many presents (0 - run forever)
+    static std::shared_ptr<HeadlessWindow> create(IDevice* pDevice, uint32_t nSwapChainImages, uint2 vRes,
+        double fPresentIntervalMs = 0, uint32_t nMaxFrames = 0);
+
+    // IWindow interface
+    virtual std::shared_ptr<IResource> getNextImage() override;
+    virtual void present() override;
+    virtual bool pollEvents() override;
+
+    // percentiles (p in [0, 100]) in milliseconds. frame time is the time between two consecutive
+    // presents, frame latency is the time between getNextImage() and the following present(). without
+    // nMaxFrames they cover the last s_nMaxSamples frames
+    double getFrameTimePercentile(double p) const;
+    double getFrameLatencyPercentile(double p) const;
+    uint32_t getNumPresentedFrames() const { return m_nPresentedFrames; }
+    void printStats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    static constexpr uint32_t s_nMaxSamples = 65536;
+
+    std::vector<std::shared_ptr<IResource>> m_pImages;
+    // value of m_pPresentFence signalled when the image was last presented
+    std::vector<uint64_t> m_imageFenceValues;
+    std::shared_ptr<IFence> m_pPresentFence;
+    uint32_t m_currentImageIndex = 0;
+    uint32_t m_nPresentedFrames = 0, m_nMaxFrames = 0;
+
+    Clock::duration m_presentInterval{};
+    Clock::time_point m_lastPresentTime, m_nextImageTime;
+    // m_nMaxSamples at most, older frames are overwritten
+    std::vector<float> m_frameTimesMs, m_frameLatenciesMs;
+    uint32_t m_nMaxSamples = 0;
+};
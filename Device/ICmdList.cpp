@@ -0,0 +1,148 @@
+#include "framework.h"
+#include "ICmdList.h"
+#include "IResource.h"
+#include "UploadRing.h"
+#include <algorithm>
+#include <cassert>
+
+void ICmdList::copyFromStaging(IResource* pDstTexture2D, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow, uint32_t nSrcRows)
+{
+    // the rows are clipped to the texture - rows of blocks for the block-compressed formats
+    IResource::ResDesc desc;
+    pDstTexture2D->getDesc(desc);
+    uint32_t nBlockSize = IResource::getBlockSize(desc.m_format);
+    uint32_t nWidth = std::min(nSrcBytesPerRow / IResource::getBytesPerPixel(desc.m_format) * nBlockSize, desc.m_res[0]);
+    uint32_t nHeight = std::min(nSrcRows * nBlockSize, desc.m_res[1]);
+    copyFromStaging(pDstTexture2D, ibox2(int2(0, 0), int2(int(nWidth) - 1, int(nHeight) - 1)), pSrcBuffer, nSrcOffset, nSrcBytesPerRow);
+}
+
+void ICmdList::transition(IResource* pResource, eBarrier eState)
+{
+    ResourceState* pState = findState(pResource);
+    if (!pState)
+    {
+        // the lists leave resources in the common state - where that is not the case the queue puts a barrier
+        // in front of the list on execute
+        ResourceState state;
+        state.m_pResource = pResource;
+        m_states.push_back(state);
+        pState = &m_states.back();
+    }
+    eBarrier eCurState = pState->m_eLast;
+    if (eCurState == eState)
+        return;
+    pState->m_eLast = eState;
+
+    // a pending transition of the same resource is merged - or dropped if it turns into a no-op
+    auto it = std::find_if(m_pendingBarriers.begin(), m_pendingBarriers.end(),
+        [pResource](const Barrier& b) { return b.m_pResource == pResource; });
+    if (it != m_pendingBarriers.end())
+    {
+        if (it->m_eStateBefore == eState)
+        {
+            m_pendingBarriers.erase(it);
+        }
+        else
+        {
+            it->m_eStateAfter = eState;
+        }
+        return;
+    }
+
+    Barrier barrier;
+    barrier.m_pResource = pResource;
+    barrier.m_eStateBefore = eCurState;
+    barrier.m_eStateAfter = eState;
+    m_pendingBarriers.push_back(barrier);
+}
+
+void ICmdList::barrier(IResource* pResource, eBarrier eStateBefore, eBarrier eStateAfter)
+{
+    if (!findState(pResource))
+    {
+        ResourceState state;
+        state.m_pResource = pResource;
+        state.m_eFirst = state.m_eLast = eStateBefore;
+        m_states.push_back(state);
+    }
+    assert(findState(pResource)->m_eLast == eStateBefore && "Resource is not in the expected state");
+    transition(pResource, eStateAfter);
+}
+
+ICmdList::ResourceState* ICmdList::findState(IResource* pResource)
+{
+    auto it = std::find_if(m_states.begin(), m_states.end(),
+        [pResource](const ResourceState& state) { return state.m_pResource == pResource; });
+    return it != m_states.end() ? &*it : nullptr;
+}
+
+void ICmdList::flushBarriers()
+{
+    if (m_pendingBarriers.empty())
+        return;
+    barriersImpl(m_pendingBarriers);
+    // clear() keeps the capacity for the next use of the pooled list
+    m_pendingBarriers.clear();
+}
+
+ICmdList::~ICmdList()
+{
+    releaseUnexecuted();
+}
+
+void ICmdList::releaseUnexecuted()
+{
+    // nothing of a dropped list reaches the device - its staging memory and timestamp slots are free right away.
+    // executing the list hands both to the queue, so there is nothing left to release then
+    if (m_pUploadRing)
+    {
+        m_pUploadRing->release(*this);
+    }
+    if (m_pProfiler)
+    {
+        m_pProfiler->release(m_scopes);
+        m_scopes.clear();
+    }
+}
+
+void ICmdList::beginRecording(Profiler* pProfiler)
+{
+    releaseUnexecuted();
+    m_pProfiler = pProfiler;
+    m_scopes.clear();
+    m_openScopes.clear();
+    m_pendingBarriers.clear();
+    m_states.clear();
+    m_dirtyRects.clear();
+}
+
+void ICmdList::beginScope(const char* sName)
+{
+    // the timestamp has to come after pending transitions, they belong to the work before the scope
+    flushBarriers();
+    Profiler::Scope scope;
+    scope.m_sName = sName;
+    scope.m_uBegin = writeTimestamp();
+    m_openScopes.push_back(m_scopes.size());
+    m_scopes.push_back(std::move(scope));
+}
+
+void ICmdList::endScope()
+{
+    assert(!m_openScopes.empty() && "endScope() without beginScope()");
+    flushBarriers();
+    m_scopes[m_openScopes.back()].m_uEnd = writeTimestamp();
+    m_openScopes.pop_back();
+}
+
+uint32_t ICmdList::writeTimestamp()
+{
+    if (!m_pProfiler)
+        return Profiler::s_nInvalidSlot;
+    uint32_t uSlot = m_pProfiler->allocateTimestamp();
+    if (uSlot != Profiler::s_nInvalidSlot)
+    {
+        writeTimestampImpl(uSlot);
+    }
+    return uSlot;
+}
@@ -1,5 +1,10 @@
 #pragma once
 #include <memory>
+#include <vector>
+#include <span>
+#include <cassert>
+#include "Profiler.h"
+#include "math/box.h"
 
 enum eBarrier
 {
@@ -9,10 +14,133 @@ enum eBarrier
 };
 
 struct IResource;
+class UploadRing;
 
 struct ICmdList : public std::enable_shared_from_this<ICmdList>
 {
-    virtual void barrier(IResource* pResource, eBarrier eStateBefore, eBarrier eStateAfter) = 0;
-    virtual void copyFromStaging(IResource* pDstTexture2D, IResource* pSrcBuffer, uint32_t nSrcBytesPerRow) = 0;
-    virtual void copy(IResource* pDst, IResource* pSrc) = 0;
+    struct Barrier
+    {
+        IResource* m_pResource = nullptr;
+        eBarrier m_eStateBefore = eBarrierStateCommon;
+        eBarrier m_eStateAfter = eBarrierStateCommon;
+    };
+
+    // a list destroyed without being executed hands its staging memory and timestamp slots back
+    virtual ~ICmdList();
+
+    // state of a resource within the list: the state the list needs it in when it starts, and the state it leaves it in
+    struct ResourceState
+    {
+        IResource* m_pResource = nullptr;
+        eBarrier m_eFirst = eBarrierStateCommon;
+        eBarrier m_eLast = eBarrierStateCommon;
+    };
+
+    // moves the resource into eState. the states are tracked per list, starting from the common state, so redundant
+    // transitions are dropped and pending ones go out as a single batch before the next copy (or on execute). the
+    // queue resolves the states against the previously executed lists on execute (see IResource::getCommittedState())
+    void transition(IResource* pResource, eBarrier eState);
+    // same as transition(), eStateBefore must match the state the list left the resource in - or is the state the
+    // list starts with if it did not use the resource yet
+    void barrier(IResource* pResource, eBarrier eStateBefore, eBarrier eStateAfter);
+    // records the pending transitions
+    void flushBarriers();
+
+    // copies nSrcRows rows of nSrcBytesPerRow bytes starting at nSrcOffset of the buffer into the top-left corner
+    // of the texture (clipped to the texture). nSrcOffset must be aligned to UploadRing::s_nTextureAlignment
+    void copyFromStaging(IResource* pDstTexture2D, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow, uint32_t nSrcRows);
+    // copies the rows of the buffer into dstRect of mip uMip of the texture (inclusive texel bounds, see math/box.h) -
+    // one row of nSrcBytesPerRow bytes per texel row (block row for block-compressed textures, whose rects cover whole
+    // blocks or end at the edge of the mip) of the rect. nSrcBytesPerRow must be aligned to UploadRing::s_nRowPitchAlignment
+    inline void copyFromStaging(IResource* pDstTexture2D, const ibox2& dstRect, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow,
+        uint32_t uMip = 0)
+    {
+        if (dstRect.isempty())
+            return;
+        flushBarriers();
+        copyFromStagingImpl(pDstTexture2D, dstRect, pSrcBuffer, nSrcOffset, nSrcBytesPerRow, uMip);
+    }
+    inline void copy(IResource* pDst, IResource* pSrc)
+    {
+        flushBarriers();
+        copyImpl(pDst, pSrc);
+    }
+    // copies srcBox of pSrc (inclusive texel bounds) to dstOffset of pDst. the textures have the same format and
+    // the box fits into both of them. boxes of block-compressed textures cover whole blocks. the CPU backend can
+    // also copy block-compressed textures into RGBA8 ones, here and in copy(), decoding the blocks
+    inline void copyRegion(IResource* pDst, const int3& dstOffset, IResource* pSrc, const ibox3& srcBox)
+    {
+        if (srcBox.isempty())
+            return;
+        flushBarriers();
+        copyRegionImpl(pDst, dstOffset, pSrc, srcBox);
+    }
+
+    // notes that the list writes rect (inclusive texel bounds) of the top level of the resource - the queue adds it
+    // to the dirty rects of the resource when it executes the list (see IResource::takeDirtyRects())
+    inline void addDirtyRect(IResource* pResource, const ibox2& rect)
+    {
+        if (!rect.isempty())
+            m_dirtyRects.push_back(DirtyRect{ pResource, rect });
+    }
+
+    // measures the time the device spends on the commands between beginScope() and endScope() - see
+    // IQueue::collectScopeTimes(). scopes may nest
+    void beginScope(const char* sName);
+    void endScope();
+
+    // used by the queues: starts a recording with the profiler of the queue. what a previous recording that was
+    // dropped without being executed still holds is released
+    void beginRecording(Profiler* pProfiler);
+    // the scopes recorded in the list. the queue hands them to its profiler when it executes the list
+    inline std::vector<Profiler::Scope>& getScopes()
+    {
+        assert(m_openScopes.empty() && "Scope was not ended");
+        return m_scopes;
+    }
+    // the resources the list uses, in order of first use
+    inline const std::vector<ResourceState>& getResourceStates() const { return m_states; }
+    struct DirtyRect
+    {
+        IResource* m_pResource = nullptr;
+        ibox2 m_rect;
+    };
+    inline const std::vector<DirtyRect>& getDirtyRects() const { return m_dirtyRects; }
+    // used by UploadRing: the blocks of the ring and the dedicated buffers the list reads staging memory from. the
+    // queue hands them back to the ring when it executes the list
+    inline UploadRing* getUploadRing() const { return m_pUploadRing; }
+    inline void setUploadRing(UploadRing* pUploadRing) { m_pUploadRing = pUploadRing; }
+    inline std::vector<uint64_t>& getStagingBlocks() { return m_stagingBlocks; }
+    inline std::vector<std::shared_ptr<IResource>>& getStagingBuffers() { return m_pStagingBuffers; }
+    inline const std::vector<Profiler::Scope>& getScopes() const
+    {
+        assert(m_openScopes.empty() && "Scope was not ended");
+        return m_scopes;
+    }
+
+protected:
+    virtual void barriersImpl(std::span<const Barrier> barriers) = 0;
+    virtual void copyFromStagingImpl(IResource* pDstTexture2D, const ibox2& dstRect, IResource* pSrcBuffer, uint64_t nSrcOffset, uint32_t nSrcBytesPerRow,
+        uint32_t uMip) = 0;
+    virtual void copyImpl(IResource* pDst, IResource* pSrc) = 0;
+    virtual void copyRegionImpl(IResource* pDst, const int3& dstOffset, IResource* pSrc, const ibox3& srcBox) = 0;
+    // writes the device time into the timestamp slot of the queue's profiler when the list executes
+    virtual void writeTimestampImpl(uint32_t uSlot) = 0;
+
+private:
+    uint32_t writeTimestamp();
+    // releases what a recording that was never executed holds in the upload ring and the profiler
+    void releaseUnexecuted();
+    ResourceState* findState(IResource* pResource);
+
+    std::vector<Barrier> m_pendingBarriers;
+    std::vector<ResourceState> m_states;
+    std::vector<DirtyRect> m_dirtyRects;
+    Profiler* m_pProfiler = nullptr;
+    std::vector<Profiler::Scope> m_scopes;
+    // indices into m_scopes
+    std::vector<size_t> m_openScopes;
+    UploadRing* m_pUploadRing = nullptr;
+    std::vector<uint64_t> m_stagingBlocks;
+    std::vector<std::shared_ptr<IResource>> m_pStagingBuffers;
 };
@@ -5,6 +5,8 @@
 #include <vector>
 #include "math/vector.h"
 #include "IResource.h"
+#include "ResourcePool.h"
+#include "RetireQueue.h"
 
 struct IWindow;
 struct IQueue;
@@ -13,16 +15,57 @@ struct IFence;
 
 struct IDevice : public std::enable_shared_from_this<IDevice>
 {
+    static constexpr uint32_t s_nDefaultQueueAllocators = 3;
+
+    // queues of a device run concurrently. copy queues only copy - e.g. uploads that should not wait behind
+    // presentation - and compute queues do not present. work on other queues is waited for with FenceTicket::waitGpu()
+    enum eQueueType
+    {
+        eQueueTypeDirect,
+        eQueueTypeCompute,
+        eQueueTypeCopy
+    };
+
     static std::shared_ptr<IDevice> createD3D12Device(bool bUseIntegratedGpu);
+    // software device for machines without a GPU
+    static std::shared_ptr<IDevice> createCpuDevice();
 
     virtual std::shared_ptr<IWindow> createWindow(uint32_t nSwapChainImages) = 0;
-    virtual std::shared_ptr<IQueue> createQueue(const std::wstring &sName) = 0;
+    // nAllocators is the number of recordings the queue keeps memory for while they are in flight. when all of
+    // them are in flight, startRecording() waits for the oldest one to land
+    virtual std::shared_ptr<IQueue> createQueue(const std::wstring &sName, eQueueType eType = eQueueTypeDirect,
+        uint32_t nAllocators = s_nDefaultQueueAllocators) = 0;
     virtual std::shared_ptr<IResource> createResource(const IResource::ResDesc& desc) = 0;
     virtual std::shared_ptr<IResource> createSharedResource(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IResource> pResource) = 0;
-    virtual std::shared_ptr<IFence> createFence() = 0;
+    // bShared fences can be opened on other devices with createSharedFence()
+    virtual std::shared_ptr<IFence> createFence(bool bShared = false) = 0;
+    // makes pFence (created with bShared on pOtherDevice) usable by the queues of this device, so that the two
+    // devices wait for each other on their GPU timelines. returns pFence - both devices share its values
+    virtual std::shared_ptr<IFence> createSharedFence(std::shared_ptr<IDevice> pOtherDevice, std::shared_ptr<IFence> pFence) = 0;
 
     inline const std::wstring& getDesc() const { return m_sDesc; }
 
+    // same as createResource(), but reuses resources handed back with releaseResource()
+    inline std::shared_ptr<IResource> createPooledResource(const IResource::ResDesc& desc)
+    {
+        return m_resourcePool.allocate(this, desc);
+    }
+    // the resource can be reused once pFence reaches fenceValue (the last use of the resource)
+    inline void releaseResource(std::shared_ptr<IResource> pResource, std::shared_ptr<IFence> pFence, uint64_t fenceValue)
+    {
+        m_resourcePool.release(this, std::move(pResource), std::move(pFence), fenceValue);
+    }
+    inline ResourcePool& getResourcePool() { return m_resourcePool; }
+
+    // keeps the object alive until the ticket lands, then releases it on a background thread
+    inline void retire(std::shared_ptr<void> pObject, const FenceTicket& ticket)
+    {
+        m_retireQueue.retire(std::move(pObject), ticket);
+    }
+
 protected:
     std::wstring m_sDesc;
+    ResourcePool m_resourcePool;
+    // drained by the destructors of the devices, while their objects can still be released
+    RetireQueue m_retireQueue{ this };
 };
\ No newline at end of file
@@ -1,11 +1,26 @@
 #pragma once
 #include <memory>
+#include <atomic>
+#include <span>
+#include <cstdint>
 #include <assert.h>
 
 struct IQueue;
+struct FenceTicket;
 
 struct IFence : public std::enable_shared_from_this<IFence>
 {
+    // same value as INFINITE of the Win32 wait functions
+    static constexpr uint32_t s_nInfinite = UINT32_MAX;
+
+    // a queue in deferred mode hands out tickets for values it signals only when it submits its collected command
+    // lists (see IQueue::setDeferred()) - waiting for such a value submits them first
+    struct DeferredSubmitter
+    {
+        virtual void submitDeferred() = 0;
+    };
+    inline void setDeferredSubmitter(DeferredSubmitter* pSubmitter) { m_pDeferredSubmitter = pSubmitter; }
+
     inline void signalGpuFence(IQueue* pQueue, uint64_t value)
     {
         signalGpuFenceImpl(pQueue, value);
@@ -13,6 +28,14 @@ struct IFence : public std::enable_shared_from_this<IFence>
         uint64_t prevValue = m_lastSignalledValue.exchange(value);
         assert(value > prevValue); // must be monotonous
     }
+    // sets the fence from the CPU, e.g. to wake up a thread that waits for several fences with waitAny()
+    inline void signalCpuFence(uint64_t value)
+    {
+        // recorded first - a waiter that sees the value land must not find it unsignalled
+        uint64_t prevValue = m_lastSignalledValue.exchange(value);
+        assert(value > prevValue); // must be monotonous
+        signalCpuFenceImpl(value);
+    }
     inline uint64_t getLastSignalledValue() const
     {
         return m_lastSignalledValue.load();
@@ -21,7 +44,8 @@ struct IFence : public std::enable_shared_from_this<IFence>
     {
         if (value <= m_lastLandedValue)
             return;
-        assert(value <= m_lastSignalledValue); // should not wait if not signalled
+        submitIfDeferred(value);
+        assert(value <= m_lastSignalledValue && "Waiting for a fence value that was never submitted");
         waitGpuFenceImpl(pQueue, value);
     }
     inline uint64_t getLastLandedValue()
@@ -31,26 +55,131 @@ struct IFence : public std::enable_shared_from_this<IFence>
         return value;
     }
     inline void waitCpuFence(uint64_t value)
+    {
+        waitCpuFence(value, s_nInfinite);
+    }
+    // returns false if the fence did not reach the value within nTimeoutMs
+    inline bool waitCpuFence(uint64_t value, uint32_t nTimeoutMs)
     {
         if (value <= m_lastLandedValue)
-            return;
-        assert(value <= m_lastSignalledValue); // should not wait if not signalled
-        waitCpuFenceImpl(value);
+            return true;
+        submitIfDeferred(value);
+        assert(value <= m_lastSignalledValue && "Waiting for a fence value that was never submitted");
+        if (!waitCpuFenceImpl(value, nTimeoutMs))
+            return false;
         updateLastLandedValue(value);
+        return true;
     }
 
+    // wait for several fences at once (e.g. of the render and the present device). all fences must be of the
+    // same backend, invalid tickets count as landed. waitAny() returns the index of a landed ticket or -1 on timeout
+    static int waitAny(std::span<const FenceTicket> tickets, uint32_t nTimeoutMs = s_nInfinite);
+    static bool waitAll(std::span<const FenceTicket> tickets, uint32_t nTimeoutMs = s_nInfinite);
+
 protected:
     virtual void signalGpuFenceImpl(IQueue* pQueue, uint64_t value) = 0;
+    virtual void signalCpuFenceImpl(uint64_t value) = 0;
     virtual void waitGpuFenceImpl(IQueue* pQueue, uint64_t value) = 0;
     virtual uint64_t getLastLandedValueImpl() = 0;
-    virtual void waitCpuFenceImpl(uint64_t value) = 0;
+    virtual bool waitCpuFenceImpl(uint64_t value, uint32_t nTimeoutMs) = 0;
+    // waits for any or all of the tickets (invalid ones count as landed). returns the index of a landed
+    // ticket (any index if bAll) or -1 on timeout
+    virtual int waitManyImpl(std::span<const FenceTicket> tickets, bool bAll, uint32_t nTimeoutMs) = 0;
 
     inline void updateLastLandedValue(uint64_t value)
     {
-        uint64_t prevValue = m_lastLandedValue.exchange(value);
-        assert(value >= prevValue); // must be monotonous
+        // the landed value may be observed from several places (e.g. by waitCpuFenceImpl() before
+        // waitCpuFence() records the value it waited for) - only ever move it forward
+        uint64_t prevValue = m_lastLandedValue.load();
+        while (prevValue < value && !m_lastLandedValue.compare_exchange_weak(prevValue, value))
+            ;
     }
 
 private:
+    inline void submitIfDeferred(uint64_t value)
+    {
+        if (value <= m_lastSignalledValue)
+            return;
+        if (DeferredSubmitter* pSubmitter = m_pDeferredSubmitter.load())
+        {
+            pSubmitter->submitDeferred();
+        }
+    }
+
     std::atomic<uint64_t> m_lastSignalledValue = 0, m_lastLandedValue = 0;
-};
\ No newline at end of file
+    std::atomic<DeferredSubmitter*> m_pDeferredSubmitter = nullptr;
+};
+
+// a point on the timeline of a fence - the work it stands for is complete once the fence reaches m_value
+struct FenceTicket
+{
+    std::shared_ptr<IFence> m_pFence;
+    uint64_t m_value = 0;
+
+    inline bool isValid() const { return m_pFence != nullptr; }
+    inline bool isReady() const
+    {
+        return !m_pFence || m_pFence->getLastLandedValue() >= m_value;
+    }
+    inline void waitCpu() const
+    {
+        if (m_pFence)
+            m_pFence->waitCpuFence(m_value);
+    }
+    // returns false on timeout
+    inline bool waitCpu(uint32_t nTimeoutMs) const
+    {
+        return !m_pFence || m_pFence->waitCpuFence(m_value, nTimeoutMs);
+    }
+    // makes pQueue wait on the GPU timeline - the fence must be usable by the device of pQueue
+    inline void waitGpu(IQueue* pQueue) const
+    {
+        if (m_pFence)
+            m_pFence->waitGpuFence(pQueue, m_value);
+    }
+};
+
+inline int IFence::waitAny(std::span<const FenceTicket> tickets, uint32_t nTimeoutMs)
+{
+    IFence* pWaitFence = nullptr;
+    for (size_t u = 0; u < tickets.size(); ++u)
+    {
+        if (tickets[u].isReady())
+            return int(u);
+        pWaitFence = tickets[u].m_pFence.get();
+        pWaitFence->submitIfDeferred(tickets[u].m_value);
+    }
+    if (!pWaitFence)
+        return -1;
+    int iLanded = pWaitFence->waitManyImpl(tickets, false, nTimeoutMs);
+    if (iLanded >= 0)
+    {
+        tickets[iLanded].m_pFence->updateLastLandedValue(tickets[iLanded].m_value);
+    }
+    return iLanded;
+}
+
+inline bool IFence::waitAll(std::span<const FenceTicket> tickets, uint32_t nTimeoutMs)
+{
+    IFence* pWaitFence = nullptr;
+    for (auto& ticket : tickets)
+    {
+        if (!ticket.isReady())
+        {
+            pWaitFence = ticket.m_pFence.get();
+            pWaitFence->submitIfDeferred(ticket.m_value);
+        }
+    }
+    if (!pWaitFence)
+        return true;
+    if (pWaitFence->waitManyImpl(tickets, true, nTimeoutMs) < 0)
+        return false;
+    for (auto& ticket : tickets)
+    {
+        if (ticket.m_pFence)
+        {
+            ticket.m_pFence->updateLastLandedValue(ticket.m_value);
+        }
+    }
+    return true;
+}
@@ -3,18 +3,299 @@
 #include "IDevice.h"
 #include "ICmdList.h"
 #include "IFence.h"
+#include "UploadRing.h"
+#include "Trace.h"
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <span>
+#include <vector>
+#include <string>
+#include <unordered_map>
 
-struct IQueue : public std::enable_shared_from_this<IQueue>
+struct IQueue : public std::enable_shared_from_this<IQueue>, private IFence::DeferredSubmitter
 {
 public:
-    virtual ~IQueue() = default;
-    virtual std::shared_ptr<ICmdList> startRecording() = 0;
-    virtual void execute(std::shared_ptr<ICmdList> pCmdList) = 0;
+    // per-thread recording state of a backend (command allocators and lists), so that threads record in parallel
+    struct RecordingPool
+    {
+        virtual ~RecordingPool() = default;
+        // also taken by the submitting thread when it hands the memory of executed lists back
+        std::mutex m_mutex;
+    };
+
+    virtual ~IQueue()
+    {
+        if (m_pFence)
+        {
+            m_pFence->setDeferredSubmitter(nullptr);
+        }
+    }
+    // thread-safe: every thread records with its own allocators and command lists
+    inline std::shared_ptr<ICmdList> startRecording()
+    {
+        return startRecordingImpl(getRecordingPool());
+    }
     virtual void flush() = 0;
 
+    // returns the ticket that lands once the command list has been executed
+    inline FenceTicket execute(std::shared_ptr<ICmdList> pCmdList)
+    {
+        return execute(std::span<const std::shared_ptr<ICmdList>>(&pCmdList, 1));
+    }
+    // submits the command lists in order with a single fence signal - e.g. the lists recorded by several threads
+    // (see SubmitBatch). submissions from several threads are serialized
+    inline FenceTicket execute(std::span<const std::shared_ptr<ICmdList>> pCmdLists)
+    {
+        std::lock_guard<std::mutex> lock(m_submitMutex);
+        if (m_bDeferred)
+        {
+            // the lists go out with the next submit(), which signals the next fence value. their memory counts as
+            // in flight from now on
+            uint64_t fenceValue = m_pFence->getLastSignalledValue() + 1;
+            deferImpl(pCmdLists, fenceValue);
+            m_pDeferredCmdLists.insert(m_pDeferredCmdLists.end(), pCmdLists.begin(), pCmdLists.end());
+            return FenceTicket{ m_pFence, fenceValue };
+        }
+        return submitImpl(pCmdLists);
+    }
+
+    // in deferred mode execute() only collects the command lists and submit() sends them all at once. waiting
+    // for the ticket of a collected list submits them right away
+    inline void setDeferred(bool bDeferred)
+    {
+        if (!bDeferred)
+        {
+            submit();
+        }
+        std::lock_guard<std::mutex> lock(m_submitMutex);
+        m_bDeferred = bDeferred;
+        m_pFence->setDeferredSubmitter(bDeferred ? this : nullptr);
+    }
+    inline bool isDeferred() const { return m_bDeferred; }
+    // submits the collected command lists. returns the ticket of the last submission if there were none
+    inline FenceTicket submit()
+    {
+        std::lock_guard<std::mutex> lock(m_submitMutex);
+        if (m_pDeferredCmdLists.empty())
+            return getLastSubmittedTicket();
+        FenceTicket ticket = submitImpl(m_pDeferredCmdLists);
+        // clear() keeps the capacity for the next frame
+        m_pDeferredCmdLists.clear();
+        return ticket;
+    }
+
     inline IDevice* getDevice() const { return m_pDevice.get(); }
+    inline const std::wstring& getName() const { return m_sName; }
+    inline IDevice::eQueueType getType() const { return m_eType; }
+    // signalled with the next value after every executed command list
+    inline const std::shared_ptr<IFence>& getFence() const { return m_pFence; }
+    // lands once everything submitted so far has been executed
+    inline FenceTicket getLastSubmittedTicket() const { return FenceTicket{ m_pFence, m_pFence->getLastSignalledValue() }; }
+    // device time (ms) spent in the scopes of command lists (see ICmdList::beginScope()) executed on this queue,
+    // summed by scope name - for the submissions that have landed since the previous call
+    inline std::unordered_map<std::string, double> collectScopeTimes()
+    {
+        if (!m_pProfiler)
+            return {};
+        return m_pProfiler->collect(m_pFence->getLastLandedValue());
+    }
+    // staging memory for uploads recorded on this queue
+    inline UploadRing* getUploadRing()
+    {
+        std::call_once(m_uploadRingOnce, [this]()
+        {
+            m_pUploadRing = std::make_unique<UploadRing>(this, UploadRing::s_nDefaultSize);
+        });
+        return m_pUploadRing.get();
+    }
 
 protected:
+    // fenceValue is signalled on m_pFence right after the command lists - their memory can be reused once it lands.
+    // called with m_submitMutex locked
+    virtual void executeImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue) = 0;
+    // deferred mode: the lists are closed and will be executed with fenceValue - startRecording() treats their
+    // memory as in flight. called with m_submitMutex locked
+    virtual void deferImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists, uint64_t fenceValue) = 0;
+    virtual std::shared_ptr<ICmdList> startRecordingImpl(RecordingPool* pPool) = 0;
+    virtual std::unique_ptr<RecordingPool> createRecordingPool() = 0;
+
+    // the pool of the calling thread, on first use one a thread that exited left behind or a new one
+    inline RecordingPool* getRecordingPool()
+    {
+        thread_local ThreadRecordingPools threadPools;
+        auto& entries = threadPools.m_entries;
+        for (size_t u = 0; u < entries.size(); )
+        {
+            // the weak pointers keep the control blocks alive, so the owner of a destroyed queue never matches again
+            auto& pFreePools = entries[u].m_pFreePools;
+            if (!pFreePools.owner_before(m_pFreeRecordingPools) && !m_pFreeRecordingPools.owner_before(pFreePools))
+                return entries[u].m_pPool;
+            // the queue is gone
+            if (pFreePools.expired())
+            {
+                entries.erase(entries.begin() + u);
+            }
+            else
+            {
+                ++u;
+            }
+        }
+
+        RecordingPool* pPool = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_pFreeRecordingPools->m_mutex);
+            if (!m_pFreeRecordingPools->m_pPools.empty())
+            {
+                pPool = m_pFreeRecordingPools->m_pPools.back();
+                m_pFreeRecordingPools->m_pPools.pop_back();
+            }
+        }
+        if (!pPool)
+        {
+            std::lock_guard<std::mutex> lock(m_recordingPoolsMutex);
+            m_pRecordingPools.push_back(createRecordingPool());
+            pPool = m_pRecordingPools.back().get();
+        }
+        entries.push_back(ThreadRecordingPools::Entry{ m_pFreeRecordingPools, pPool });
+        return pPool;
+    }
+
+    inline FenceTicket submitImpl(std::span<const std::shared_ptr<ICmdList>> pCmdLists)
+    {
+        // Signal the fence to track completion of the command lists
+        uint64_t fenceValue = m_pFence->getLastSignalledValue() + 1;
+        executeImpl(resolveStates(pCmdLists), fenceValue);
+        // the fix-up lists go back to the pool
+        m_pResolvedCmdLists.clear();
+        m_pFence->signalGpuFence(this, fenceValue);
+        // the staging memory and the timestamp slots of every list are released once the list has executed
+        for (auto& pCmdList : pCmdLists)
+        {
+            for (auto& dirtyRect : pCmdList->getDirtyRects())
+            {
+                dirtyRect.m_pResource->addDirtyRect(dirtyRect.m_rect);
+            }
+            if (m_pProfiler)
+            {
+                m_pProfiler->onExecuted(pCmdList->getScopes(), fenceValue);
+            }
+            if (UploadRing* pUploadRing = pCmdList->getUploadRing())
+            {
+                pUploadRing->onExecuted(*pCmdList, fenceValue);
+            }
+        }
+        FenceTicket ticket{ m_pFence, fenceValue };
+        // from submission until the fence value lands
+        Trace::spanUntilLanded(m_sTraceName.c_str(), ticket);
+        return ticket;
+    }
+
+    // the lists track the states of their resources on their own - the states the lists start with are brought about
+    // here, in submission order, by fix-up lists in front of them where the previous lists left a resource otherwise.
+    // called with m_submitMutex locked
+    inline std::span<const std::shared_ptr<ICmdList>> resolveStates(std::span<const std::shared_ptr<ICmdList>> pCmdLists)
+    {
+        m_pResolvedCmdLists.clear();
+        for (auto& pCmdList : pCmdLists)
+        {
+            std::shared_ptr<ICmdList> pFixup;
+            for (auto& state : pCmdList->getResourceStates())
+            {
+                eBarrier eCommitted = state.m_pResource->getCommittedState();
+                if (eCommitted != state.m_eFirst)
+                {
+                    if (!pFixup)
+                    {
+                        // from a pool of their own - the pool of the submitting thread may be full of lists that
+                        // wait for this very submission
+                        if (!m_pFixupPool)
+                        {
+                            m_pFixupPool = createRecordingPool();
+                        }
+                        pFixup = startRecordingImpl(m_pFixupPool.get());
+                    }
+                    pFixup->barrier(state.m_pResource, eCommitted, state.m_eFirst);
+                }
+                state.m_pResource->setCommittedState(state.m_eLast);
+            }
+            if (pFixup)
+            {
+                m_pResolvedCmdLists.push_back(std::move(pFixup));
+            }
+            m_pResolvedCmdLists.push_back(pCmdList);
+        }
+        return m_pResolvedCmdLists;
+    }
+
+    inline void setName(const std::wstring& sName)
+    {
+        m_sName = sName;
+        m_sTraceName.clear();
+        for (wchar_t c : sName)
+        {
+            m_sTraceName.push_back(c < 128 ? char(c) : '?');
+        }
+    }
+
     std::shared_ptr<IDevice> m_pDevice;
+    std::shared_ptr<IFence> m_pFence;
+    IDevice::eQueueType m_eType = IDevice::eQueueTypeDirect;
+    std::wstring m_sName;
+    // ASCII copy of m_sName for the trace
+    std::string m_sTraceName;
+    // the ring and the profiler are declared before the lists, so that lists destroyed with the queue can still
+    // hand their holdings back
+    std::once_flag m_uploadRingOnce;
+    std::unique_ptr<UploadRing> m_pUploadRing;
+    // created by the backend if it supports timestamps
+    std::unique_ptr<Profiler> m_pProfiler;
+    bool m_bDeferred = false;
+    std::vector<std::shared_ptr<ICmdList>> m_pDeferredCmdLists;
+    // scratch array of resolveStates(), guarded by m_submitMutex
+    std::vector<std::shared_ptr<ICmdList>> m_pResolvedCmdLists;
+    // records the fix-up lists of resolveStates(), guarded by m_submitMutex
+    std::unique_ptr<RecordingPool> m_pFixupPool;
+    std::mutex m_submitMutex;
+    std::mutex m_recordingPoolsMutex;
+    // the pools of all threads that recorded on the queue
+    std::vector<std::unique_ptr<RecordingPool>> m_pRecordingPools;
+    // pools of threads that exited, taken by the next new thread. shared with the thread-local entries of the threads
+    // that record on the queue, which hand their pools back here when the thread exits - unless the queue is gone
+    struct FreeRecordingPools
+    {
+        std::mutex m_mutex;
+        std::vector<RecordingPool*> m_pPools;
+    };
+    std::shared_ptr<FreeRecordingPools> m_pFreeRecordingPools = std::make_shared<FreeRecordingPools>();
+
+private:
+    // IFence::DeferredSubmitter - a wait for the ticket of a collected list
+    virtual void submitDeferred() override
+    {
+        submit();
+    }
+
+    struct ThreadRecordingPools
+    {
+        struct Entry
+        {
+            std::weak_ptr<FreeRecordingPools> m_pFreePools;
+            RecordingPool* m_pPool = nullptr;
+        };
+        std::vector<Entry> m_entries;
+
+        ~ThreadRecordingPools()
+        {
+            for (auto& entry : m_entries)
+            {
+                // the free list outlives the queue while it is locked here, the pool itself is not touched
+                if (auto pFreePools = entry.m_pFreePools.lock())
+                {
+                    std::lock_guard<std::mutex> lock(pFreePools->m_mutex);
+                    pFreePools->m_pPools.push_back(entry.m_pPool);
+                }
+            }
+        }
+    };
 };
\ No newline at end of file
@@ -1,5 +1,14 @@
 #include "framework.h"
 #include "IResource.h"
+#include "IQueue.hpp"
+#include "TextureCache.h"
+#include "DecodeService.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#define STB_IMAGE_IMPLEMENTATION
+#include "external/stb/stb_image.h"
 
 uint32_t IResource::getBytesPerPixel(eFormat format)
 {
@@ -7,8 +16,290 @@ uint32_t IResource::getBytesPerPixel(eFormat format)
     {
     case eFormatRGBA8:
         return 4;  // 8 bits per channel * 4 channels = 32 bits = 4 bytes
+    case eFormatBC1:
+        return 8;  // 4x4 block: two 565 colors and 2-bit indices
+    case eFormatBC3:
+    case eFormatBC7:
+        return 16;
     case eFormatUnknown:
     default:
         return 0;  // Unknown format, return 0
     }
-} 
\ No newline at end of file
+}
+
+uint32_t IResource::getBlockSize(eFormat format)
+{
+    switch (format)
+    {
+    case eFormatBC1:
+    case eFormatBC3:
+    case eFormatBC7:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+uint32_t IResource::getPackedRowPitch(eFormat format, uint32_t nWidth)
+{
+    uint32_t nBlockSize = getBlockSize(format);
+    return (nWidth + nBlockSize - 1) / nBlockSize * getBytesPerPixel(format);
+}
+
+uint32_t IResource::getBlockRows(eFormat format, uint32_t nHeight)
+{
+    uint32_t nBlockSize = getBlockSize(format);
+    return (nHeight + nBlockSize - 1) / nBlockSize;
+}
+
+size_t IResource::ResDesc::hash() const
+{
+    // FNV-1a over all fields that take part in operator ==
+    uint64_t h = 14695981039346656037ull;
+    auto combine = [&h](uint64_t v)
+    {
+        h ^= v;
+        h *= 1099511628211ull;
+    };
+    combine(m_format);
+    combine(m_nDims);
+    combine(m_nMips);
+    for (uint32_t r : m_res)
+        combine(r);
+    combine((m_isStaging ? 1 : 0) | (m_isShared ? 2 : 0) | (m_isPersistentlyMapped ? 4 : 0) | (m_isReadback ? 8 : 0));
+    return size_t(h);
+}
+
+uint64_t IResource::getUploadFootprints(uint32_t nWidth, uint32_t nHeight, uint32_t nMips, std::vector<Footprint>& outLevels)
+{
+    ResDesc desc;
+    getDesc(desc);
+    outLevels.resize(nMips);
+    uint64_t nTotalBytes = 0;
+    for (uint32_t uMip = 0; uMip < nMips; ++uMip)
+    {
+        Footprint& level = outLevels[uMip];
+        level.m_nWidth = MipChain::getLevelSize(nWidth, uMip);
+        level.m_nHeight = MipChain::getLevelSize(nHeight, uMip);
+        level.m_nRowPitch = (getPackedRowPitch(desc.m_format, level.m_nWidth) + UploadRing::s_nRowPitchAlignment - 1) & ~(UploadRing::s_nRowPitchAlignment - 1);
+        level.m_nRows = getBlockRows(desc.m_format, level.m_nHeight);
+        level.m_nOffset = (nTotalBytes + UploadRing::s_nTextureAlignment - 1) & ~(UploadRing::s_nTextureAlignment - 1);
+        nTotalBytes = level.m_nOffset + uint64_t(level.m_nRowPitch) * level.m_nRows;
+    }
+    return nTotalBytes;
+}
+
+FenceTicket IResource::loadFromFileAsync(const std::filesystem::path& sPath, IQueue* pQueue)
+{
+    ResDesc desc;
+    getDesc(desc);
+    if (desc.m_nMips == 1)
+    {
+        // the rows go straight from the cache mapping (or the decoded image) to the upload ring. the staging memory
+        // belongs to the list - it is released with the list if the decode fails
+        auto pCmdList = pQueue->startRecording();
+        assert(pCmdList && "Failed to get command list from queue");
+        std::vector<Footprint> footprints;
+        UploadRing::Allocation staging;
+        DecodedImage image;
+        bool bDecoded = image.decodeInto(sPath, desc.m_format, [&](uint32_t nWidth, uint32_t nHeight, uint32_t& outRowPitch)
+        {
+            staging = pQueue->getUploadRing()->allocate(pCmdList.get(), getUploadFootprints(nWidth, nHeight, 1, footprints));
+            outRowPitch = footprints[0].m_nRowPitch;
+            return staging.m_pData;
+        });
+        if (!bDecoded)
+        {
+            assert(false && "Failed to load image");
+            return FenceTicket();
+        }
+        recordUploadFromStaging(pCmdList.get(), staging.m_pBuffer, staging.m_nOffset, footprints);
+        return pQueue->execute(pCmdList);
+    }
+
+    // Use the pixels cached by a previous run if the source has not changed
+    TextureCache::MappedImage cache;
+    if (cache.open(sPath))
+    {
+        const auto& header = cache.getHeader();
+        uint32_t nMips = std::min(desc.m_nMips, MipChain::getFullCount(header.m_nWidth, header.m_nHeight));
+        if (header.m_format == desc.m_format && header.m_nMips == nMips)
+        {
+            return loadFromMemoryAsync(cache.getPixels(), header.m_nWidth, header.m_nHeight, pQueue, header.m_nRowPitch, nMips);
+        }
+    }
+
+    // decode the image into the format of the resource and generate its mips - that writes the cache for the next time
+    DecodedImage image;
+    if (!image.decode(sPath, desc.m_format, desc.m_nMips))
+    {
+        assert(false && "Failed to load image");
+        return FenceTicket();
+    }
+    return loadFromMemoryAsync(image.m_pixels.data(), image.m_nWidth, image.m_nHeight, pQueue, 0, image.m_nMips);
+}
+
+FenceTicket IResource::loadFromMemoryAsync(const uint8_t* pPixels, uint32_t nWidth, uint32_t nHeight, IQueue* pQueue, uint32_t nSrcRowPitch, uint32_t nSrcMips)
+{
+    // Get command list from queue
+    auto pCmdList = pQueue->startRecording();
+    assert(pCmdList && "Failed to get command list from queue");
+
+    recordUpload(pCmdList.get(), pPixels, nWidth, nHeight, pQueue, nSrcRowPitch, nSrcMips);
+
+    // Execute command list - the staging memory of the list is recycled by the upload ring once the copy lands
+    return pQueue->execute(pCmdList);
+}
+
+void IResource::recordUpload(ICmdList* pCmdList, const uint8_t* pPixels, uint32_t nWidth, uint32_t nHeight, IQueue* pQueue, uint32_t nSrcRowPitch, uint32_t nSrcMips)
+{
+    ResDesc desc;
+    getDesc(desc);
+    if (nSrcRowPitch == 0)
+    {
+        nSrcRowPitch = getPackedRowPitch(desc.m_format, nWidth);
+    }
+    if (nSrcMips > 1 && desc.m_nMips > 1)
+    {
+        assert(nSrcRowPitch == getPackedRowPitch(desc.m_format, nWidth) && "Mip chains have tightly packed rows");
+        recordUploadMips(pCmdList, pPixels, nWidth, nHeight, std::min(nSrcMips, desc.m_nMips), pQueue);
+        return;
+    }
+    // the image is clipped to the texture
+    ibox2 rect(int2(0, 0), int2(int(std::min(nWidth, desc.m_res[0])) - 1, int(std::min(nHeight, desc.m_res[1])) - 1));
+    recordUploadRects(pCmdList, pPixels, nSrcRowPitch, std::span<const ibox2>(&rect, 1), pQueue);
+}
+
+void IResource::recordUploadRects(ICmdList* pCmdList, const uint8_t* pPixels, uint32_t nSrcRowPitch, std::span<const ibox2> rects, IQueue* pQueue)
+{
+    ResDesc desc;
+    getDesc(desc);
+    int nBlockSize = int(getBlockSize(desc.m_format));
+    uint32_t nBytesPerBlock = getBytesPerPixel(desc.m_format);
+
+    // Transition resource to copy destination using ICmdList interface
+    pCmdList->transition(this, eBarrierStateCopyDst);
+
+    pCmdList->beginScope("upload");
+    for (const ibox2& rect : rects)
+    {
+        if (rect.isempty())
+            continue;
+        // the rect in blocks (in texels for uncompressed formats)
+        ibox2 blocks(rect.m_mins / nBlockSize, rect.m_maxs / nBlockSize);
+        ibox2 dstRect(blocks.m_mins * nBlockSize, (blocks.m_maxs + 1) * nBlockSize - 1);
+
+        // Copy the rect into the upload ring of the queue
+        uint32_t nRowBytes = uint32_t(blocks.m_maxs.x - blocks.m_mins.x + 1) * nBytesPerBlock;
+        uint32_t nRows = uint32_t(blocks.m_maxs.y - blocks.m_mins.y + 1);
+        uint32_t nRowPitch = (nRowBytes + UploadRing::s_nRowPitchAlignment - 1) & ~(UploadRing::s_nRowPitchAlignment - 1);
+        auto staging = pQueue->getUploadRing()->allocate(pCmdList, uint64_t(nRowPitch) * nRows);
+        const uint8_t* pSrc = pPixels + uint64_t(blocks.m_mins.y) * nSrcRowPitch + uint64_t(blocks.m_mins.x) * nBytesPerBlock;
+        if (nSrcRowPitch == nRowPitch && nRowBytes == nRowPitch)
+        {
+            memcpy(staging.m_pData, pSrc, uint64_t(nRowPitch) * nRows);
+        }
+        else
+        {
+            for (uint32_t uRow = 0; uRow < nRows; ++uRow)
+            {
+                memcpy(staging.m_pData + uint64_t(uRow) * nRowPitch, pSrc + uint64_t(uRow) * nSrcRowPitch, nRowBytes);
+            }
+        }
+
+        // Copy data from staging buffer to resource using ICmdList interface
+        pCmdList->copyFromStaging(this, dstRect, staging.m_pBuffer, staging.m_nOffset, nRowPitch);
+        pCmdList->addDirtyRect(this, dstRect);
+    }
+    pCmdList->endScope();
+
+    // Transition resource back to common state - recorded when the list is executed
+    pCmdList->transition(this, eBarrierStateCommon);
+}
+
+void IResource::recordUploadMips(ICmdList* pCmdList, const uint8_t* pChain, uint32_t nWidth, uint32_t nHeight, uint32_t nMips, IQueue* pQueue)
+{
+    ResDesc desc;
+    getDesc(desc);
+
+    // the levels are clipped to the levels of the texture and share one staging allocation
+    std::vector<Footprint> footprints;
+    uint64_t nTotalBytes = getUploadFootprints(std::min(nWidth, desc.m_res[0]), std::min(nHeight, desc.m_res[1]), nMips, footprints);
+    auto staging = pQueue->getUploadRing()->allocate(pCmdList, nTotalBytes);
+    for (uint32_t uMip = 0; uMip < nMips; ++uMip)
+    {
+        const Footprint& level = footprints[uMip];
+        const uint8_t* pSrc = pChain + MipChain::getLevelOffset(desc.m_format, nWidth, nHeight, uMip);
+        uint32_t nSrcRowPitch = getPackedRowPitch(desc.m_format, MipChain::getLevelSize(nWidth, uMip));
+        uint32_t nRowBytes = getPackedRowPitch(desc.m_format, level.m_nWidth);
+        for (uint32_t uRow = 0; uRow < level.m_nRows; ++uRow)
+        {
+            memcpy(staging.m_pData + level.m_nOffset + uint64_t(uRow) * level.m_nRowPitch, pSrc + uint64_t(uRow) * nSrcRowPitch, nRowBytes);
+        }
+    }
+    recordUploadFromStaging(pCmdList, staging.m_pBuffer, staging.m_nOffset, footprints);
+}
+
+void IResource::recordUploadFromStaging(ICmdList* pCmdList, IResource* pStaging, uint64_t nOffset, std::span<const Footprint> levels)
+{
+    ResDesc desc;
+    getDesc(desc);
+    assert(levels.size() <= desc.m_nMips && "The resource has fewer mips");
+
+    pCmdList->transition(this, eBarrierStateCopyDst);
+    pCmdList->beginScope("upload");
+    ibox2 topRect = ibox2::empty();
+    for (uint32_t uMip = 0; uMip < uint32_t(levels.size()); ++uMip)
+    {
+        const Footprint& level = levels[uMip];
+        uint32_t nWidth = std::min(level.m_nWidth, MipChain::getLevelSize(desc.m_res[0], uMip));
+        uint32_t nHeight = std::min(level.m_nHeight, MipChain::getLevelSize(desc.m_res[1], uMip));
+        ibox2 rect(int2(0, 0), int2(int(nWidth) - 1, int(nHeight) - 1));
+        pCmdList->copyFromStaging(this, rect, pStaging, nOffset + level.m_nOffset, level.m_nRowPitch, uMip);
+        if (uMip == 0)
+            topRect = rect;
+    }
+    pCmdList->endScope();
+    pCmdList->transition(this, eBarrierStateCommon);
+    // dirty rects track the top level
+    pCmdList->addDirtyRect(this, topRect);
+}
+
+void IResource::addDirtyRect(const ibox2& rect)
+{
+    if (rect.isempty())
+        return;
+    std::lock_guard<std::mutex> lock(m_dirtyRectsMutex);
+    // absorb every rect that overlaps or touches the new one - the union may reach further rects
+    ibox2 merged = rect;
+    for (size_t u = 0; u < m_dirtyRects.size(); )
+    {
+        if (m_dirtyRects[u].intersects(merged.grow(1)))
+        {
+            merged |= m_dirtyRects[u];
+            m_dirtyRects.erase(m_dirtyRects.begin() + u);
+            u = 0;
+            continue;
+        }
+        ++u;
+    }
+    m_dirtyRects.push_back(merged);
+
+    if (m_dirtyRects.size() > s_nMaxDirtyRects)
+    {
+        ibox2 bounds = m_dirtyRects[0];
+        for (auto& r : m_dirtyRects)
+        {
+            bounds |= r;
+        }
+        m_dirtyRects.assign(1, bounds);
+    }
+}
+
+void IResource::takeDirtyRects(std::vector<ibox2>& outRects)
+{
+    std::lock_guard<std::mutex> lock(m_dirtyRectsMutex);
+    // the vectors trade their capacity, neither side allocates in steady state
+    outRects.clear();
+    outRects.swap(m_dirtyRects);
+}
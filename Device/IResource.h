@@ -3,6 +3,11 @@
 #include <filesystem>
 #include <memory>
 #include <array>
+#include <vector>
+#include <span>
+#include <mutex>
+#include "IFence.h"
+#include "ICmdList.h"
 
 struct IDevice;
 struct IQueue;
@@ -12,27 +17,127 @@ struct IResource : public std::enable_shared_from_this<IResource>
     enum eFormat
     {
         eFormatUnknown = 0,
-        eFormatRGBA8 = 1
+        eFormatRGBA8 = 1,
+        // block-compressed, 4x4 texels per block (see BlockCodec)
+        eFormatBC1 = 2,
+        eFormatBC3 = 3,
+        eFormatBC7 = 4
     };
+    // bytes per texel - or per block for the block-compressed formats
     static uint32_t getBytesPerPixel(eFormat format);
+    // width and height in texels of the blocks the format stores (1 for uncompressed formats)
+    static uint32_t getBlockSize(eFormat format);
+    // bytes of a tightly packed row of blocks covering nWidth texels
+    static uint32_t getPackedRowPitch(eFormat format, uint32_t nWidth);
+    // rows of blocks covering nHeight texels
+    static uint32_t getBlockRows(eFormat format, uint32_t nHeight);
 
     struct ResDesc
     {
         eFormat m_format = eFormatRGBA8;
         uint32_t m_nDims = 0;
-        std::array<uint32_t, 3> m_res;
+        std::array<uint32_t, 3> m_res = { 0, 0, 0 };
+        // textures only, level i is (m_res >> i) in size, at least 1 (see MipChain)
+        uint32_t m_nMips = 1;
         bool m_isStaging = false;
         bool m_isShared = false;
+        // CPU-readable buffer that copies on the GPU write into (e.g. resolved query results)
+        bool m_isReadback = false;
+        // staging and readback resources only: mapped once at creation - map() returns the same pointer for the lifetime of
+        // the resource, unmap() does nothing and writeTo() is just a memcpy
+        bool m_isPersistentlyMapped = false;
 
+        // true if the resources have the same layout and ICmdList::copy() can copy between them
+        inline bool isCopyCompatible(const ResDesc& other) const
+        {
+            return m_format == other.m_format && m_nDims == other.m_nDims && m_res == other.m_res && m_nMips == other.m_nMips;
+        }
         inline bool operator ==(const ResDesc& other) const
         {
-            // TODO: implement
-            return true;
+            return isCopyCompatible(other) && m_isStaging == other.m_isStaging && m_isShared == other.m_isShared &&
+                m_isReadback == other.m_isReadback && m_isPersistentlyMapped == other.m_isPersistentlyMapped;
+        }
+        inline bool operator !=(const ResDesc& other) const
+        {
+            return !(*this == other);
         }
+        size_t hash() const;
     };
 
-    virtual void loadFromFile(const std::filesystem::path& sPath, IQueue* pQueue) = 0;
+    // where a level of an upload sits in staging memory: rows are UploadRing::s_nRowPitchAlignment aligned,
+    // levels UploadRing::s_nTextureAlignment aligned. sizes are in texels, rows are rows of blocks
+    struct Footprint
+    {
+        uint64_t m_nOffset = 0;
+        uint32_t m_nWidth = 0, m_nHeight = 0;
+        uint32_t m_nRowPitch = 0;
+        uint32_t m_nRows = 0;
+    };
+    // footprints of the nMips levels of an nWidth x nHeight image in the format of the resource. returns the
+    // size of the staging memory they take
+    uint64_t getUploadFootprints(uint32_t nWidth, uint32_t nHeight, uint32_t nMips, std::vector<Footprint>& outLevels);
+
+    // decodes the image (or maps its TextureCache file) and records its upload on pQueue without waiting
+    // for it. the resource holds the image once the returned ticket lands (an invalid ticket means failure).
+    // the mips of the resource are generated from the image
+    virtual FenceTicket loadFromFileAsync(const std::filesystem::path& sPath, IQueue* pQueue);
+    // uploads pixels in the format of the resource, e.g. an image decoded by DecodeService. nSrcRowPitch == 0
+    // means tightly packed rows (of blocks for the block-compressed formats). with nSrcMips > 1 pPixels is a mip
+    // chain laid out by MipChain - the levels the resource has go through one staging allocation
+    FenceTicket loadFromMemoryAsync(const uint8_t* pPixels, uint32_t nWidth, uint32_t nHeight, IQueue* pQueue,
+        uint32_t nSrcRowPitch = 0, uint32_t nSrcMips = 1);
+    // records the upload into pCmdList, which is executed by the caller on pQueue - lets several threads record
+    // uploads in parallel (see SubmitBatch)
+    void recordUpload(ICmdList* pCmdList, const uint8_t* pPixels, uint32_t nWidth, uint32_t nHeight, IQueue* pQueue,
+        uint32_t nSrcRowPitch = 0, uint32_t nSrcMips = 1);
+    // uploads only the rects (inclusive texel bounds) of an image laid out like the resource - e.g. the parts
+    // of a frame that changed. nSrcRowPitch is the row pitch of pPixels. with block-compressed formats the rects
+    // grow to whole blocks
+    void recordUploadRects(ICmdList* pCmdList, const uint8_t* pPixels, uint32_t nSrcRowPitch, std::span<const ibox2> rects,
+        IQueue* pQueue);
+    // records copies of levels that were written to staging memory at pStaging + nOffset as laid out by
+    // getUploadFootprints() - e.g. decoded straight into the upload ring. the levels are clipped to the resource
+    void recordUploadFromStaging(ICmdList* pCmdList, IResource* pStaging, uint64_t nOffset, std::span<const Footprint> levels);
+    // same as loadFromFileAsync() but waits for the upload to complete
+    inline void loadFromFile(const std::filesystem::path& sPath, IQueue* pQueue)
+    {
+        loadFromFileAsync(sPath, pQueue).waitCpu();
+    }
     virtual void getDesc(ResDesc &outDesc) = 0;
     virtual void writeTo(const char* pData, uint32_t nBytes) = 0;
+    // staging and readback resources only: CPU pointer to the contents, valid until unmap() - or for the lifetime of the resource
+    // with ResDesc::m_isPersistentlyMapped
+    virtual void* map() = 0;
+    virtual void unmap() = 0;
     virtual void setName(const std::wstring& name) = 0;
+
+    // state the command lists executed so far leave the resource in - updated by the queues in submission order (see
+    // ICmdList::transition()). resources are back in the common state when another queue takes them over
+    inline eBarrier getCommittedState() const { return m_eCommittedState; }
+    inline void setCommittedState(eBarrier eState) { m_eCommittedState = eState; }
+
+    // regions written since the consumer of the contents last took them (e.g. to copy just those to the swap chain).
+    // the command lists note the rects they write (see ICmdList::addDirtyRect()), their queue adds them here when it
+    // executes them. overlapping and adjacent rects are merged
+    void addDirtyRect(const ibox2& rect);
+    // moves the dirty rects into outRects
+    void takeDirtyRects(std::vector<ibox2>& outRects);
+
+private:
+    void recordUploadMips(ICmdList* pCmdList, const uint8_t* pChain, uint32_t nWidth, uint32_t nHeight, uint32_t nMips,
+        IQueue* pQueue);
+
+    // more rects than that collapse into their bounding box
+    static constexpr size_t s_nMaxDirtyRects = 16;
+
+    eBarrier m_eCommittedState = eBarrierStateCommon;
+    // the queues that execute uploads add the rects, the consumer takes them
+    std::mutex m_dirtyRectsMutex;
+    std::vector<ibox2> m_dirtyRects;
+};
+
+template <>
+struct std::hash<IResource::ResDesc>
+{
+    size_t operator()(const IResource::ResDesc& desc) const { return desc.hash(); }
 };
@@ -0,0 +1,114 @@
+#include "framework.h"
+#include "MipChain.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPCHAIN_SSE2 1
+#include <emmintrin.h>
+#else
+#define MIPCHAIN_SSE2 0
+#endif
+
+namespace {
+    // rows of a level per task when the filter runs on a thread pool
+    constexpr uint32_t s_nBandRows = 32;
+
+    // one row of the next level from two rows of the current one
+    void filterRow(const uint8_t* pRow0, const uint8_t* pRow1, uint32_t nSrcWidth, uint8_t* pDst, uint32_t nDstWidth)
+    {
+        uint32_t x = 0;
+#if MIPCHAIN_SSE2
+        // 4 texels of the next level from 8 texels of both rows. with a source width of 1 the column is clamped,
+        // which is left to the scalar loop
+        if (nSrcWidth > 1)
+        {
+            const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+            for ( ; x + 4 <= nDstWidth; x += 4)
+            {
+                __m128 a0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + x * 8)));
+                __m128 b0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + x * 8 + 16)));
+                __m128 a1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + x * 8)));
+                __m128 b1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + x * 8 + 16)));
+                // even and odd texels of each row
+                __m128i e0 = _mm_castps_si128(_mm_shuffle_ps(a0, b0, _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i o0 = _mm_castps_si128(_mm_shuffle_ps(a0, b0, _MM_SHUFFLE(3, 1, 3, 1)));
+                __m128i e1 = _mm_castps_si128(_mm_shuffle_ps(a1, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i o1 = _mm_castps_si128(_mm_shuffle_ps(a1, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+                __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(e0, zero), _mm_unpacklo_epi8(o0, zero)),
+                    _mm_add_epi16(_mm_unpacklo_epi8(e1, zero), _mm_unpacklo_epi8(o1, zero)));
+                __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(e0, zero), _mm_unpackhi_epi8(o0, zero)),
+                    _mm_add_epi16(_mm_unpackhi_epi8(e1, zero), _mm_unpackhi_epi8(o1, zero)));
+                lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+                hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + x * 4), _mm_packus_epi16(lo, hi));
+            }
+        }
+#endif
+        for ( ; x < nDstWidth; ++x)
+        {
+            uint32_t x0 = 2 * x, x1 = std::min(2 * x + 1, nSrcWidth - 1);
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                pDst[x * 4 + c] = uint8_t((pRow0[x0 * 4 + c] + pRow0[x1 * 4 + c] + pRow1[x0 * 4 + c] + pRow1[x1 * 4 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    void filterRows(const uint8_t* pSrc, uint32_t nSrcWidth, uint32_t nSrcHeight, uint8_t* pDst, uint32_t nDstWidth,
+        uint32_t uFirstRow, uint32_t uEndRow)
+    {
+        size_t nSrcPitch = size_t(nSrcWidth) * 4, nDstPitch = size_t(nDstWidth) * 4;
+        for (uint32_t y = uFirstRow; y < uEndRow; ++y)
+        {
+            uint32_t y0 = 2 * y, y1 = std::min(2 * y + 1, nSrcHeight - 1);
+            filterRow(pSrc + y0 * nSrcPitch, pSrc + y1 * nSrcPitch, nSrcWidth, pDst + y * nDstPitch, nDstWidth);
+        }
+    }
+}
+
+uint32_t MipChain::getFullCount(uint32_t nWidth, uint32_t nHeight)
+{
+    uint32_t nMips = 1;
+    for (uint32_t nSize = std::max(nWidth, nHeight); nSize > 1; nSize >>= 1)
+    {
+        ++nMips;
+    }
+    return nMips;
+}
+
+size_t MipChain::getLevelOffset(IResource::eFormat format, uint32_t nWidth, uint32_t nHeight, uint32_t uMip)
+{
+    size_t nOffset = 0;
+    for (uint32_t u = 0; u < uMip; ++u)
+    {
+        nOffset += size_t(IResource::getPackedRowPitch(format, getLevelSize(nWidth, u))) *
+            IResource::getBlockRows(format, getLevelSize(nHeight, u));
+    }
+    return nOffset;
+}
+
+void MipChain::generate(uint8_t* pChain, uint32_t nWidth, uint32_t nHeight, uint32_t nMips, ThreadPool* pThreadPool)
+{
+    assert(nMips <= getFullCount(nWidth, nHeight) && "Too many mip levels");
+    uint8_t* pSrc = pChain;
+    for (uint32_t uMip = 1; uMip < nMips; ++uMip)
+    {
+        uint32_t nSrcWidth = getLevelSize(nWidth, uMip - 1), nSrcHeight = getLevelSize(nHeight, uMip - 1);
+        uint32_t nDstWidth = getLevelSize(nWidth, uMip), nDstHeight = getLevelSize(nHeight, uMip);
+        uint8_t* pDst = pSrc + size_t(nSrcWidth) * nSrcHeight * 4;
+        uint32_t nBands = (nDstHeight + s_nBandRows - 1) / s_nBandRows;
+        if (pThreadPool && pThreadPool->getNumThreads() > 1 && nBands > 1)
+        {
+            pThreadPool->parallelFor(nBands, [&](uint32_t uBand)
+            {
+                filterRows(pSrc, nSrcWidth, nSrcHeight, pDst, nDstWidth, uBand * s_nBandRows, std::min(nDstHeight, (uBand + 1) * s_nBandRows));
+            });
+        }
+        else
+        {
+            filterRows(pSrc, nSrcWidth, nSrcHeight, pDst, nDstWidth, 0, nDstHeight);
+        }
+        pSrc = pDst;
+    }
+}
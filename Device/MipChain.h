@@ -0,0 +1,21 @@
+#pragma once
+
+#include "IResource.h"
+#include <cstdint>
+
+class ThreadPool;
+
+// mip chains in memory: level after level, each with tightly packed rows (of blocks for the block-compressed
+// formats). level uMip of an image is getLevelSize() texels wide and high
+struct MipChain
+{
+    static uint32_t getLevelSize(uint32_t nSize, uint32_t uMip) { return (nSize >> uMip) > 0 ? nSize >> uMip : 1; }
+    // number of levels down to 1x1
+    static uint32_t getFullCount(uint32_t nWidth, uint32_t nHeight);
+    // byte offset of level uMip - getLevelOffset(nMips) is the size of the chain
+    static size_t getLevelOffset(IResource::eFormat format, uint32_t nWidth, uint32_t nHeight, uint32_t uMip);
+
+    // fills levels 1 .. nMips - 1 of an RGBA8 chain from level 0 with a 2x2 box filter (odd sizes drop the last
+    // row / column). with a thread pool, the rows of each level are spread over its threads
+    static void generate(uint8_t* pChain, uint32_t nWidth, uint32_t nHeight, uint32_t nMips, ThreadPool* pThreadPool = nullptr);
+};
@@ -0,0 +1,483 @@
+#include "framework.h"
+#include "PixelKernels.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXELKERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC compiles intrinsics of any level without flags
+#define PIXELKERNELS_TARGET(sIsa)
+#else
+#define PIXELKERNELS_TARGET(sIsa) __attribute__((target(sIsa)))
+#endif
+#else
+#define PIXELKERNELS_X86 0
+#endif
+
+namespace {
+    typedef void (*Kernel)(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels);
+    struct Kernels
+    {
+        Kernel m_pExpandGray;
+        Kernel m_pExpandGrayAlpha;
+        Kernel m_pExpandRGB;
+        Kernel m_pSwizzleRB;
+        Kernel m_pPremultiplyAlpha;
+        Kernel m_pSrgbToLinear;
+        Kernel m_pLinearToSrgb;
+    };
+
+    // x * a / 255, rounded
+    inline uint8_t mulDiv255(uint32_t x, uint32_t a)
+    {
+        uint32_t t = x * a + 128;
+        return uint8_t((t + (t >> 8)) >> 8);
+    }
+
+    typedef std::array<uint8_t, 256> Table;
+
+    Table makeTable(bool bToLinear)
+    {
+        Table table;
+        for (int i = 0; i < 256; ++i)
+        {
+            double c = i / 255.0;
+            if (bToLinear)
+                c = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+            else
+                c = c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1 / 2.4) - 0.055;
+            table[i] = uint8_t(std::clamp(c * 255.0 + 0.5, 0.0, 255.0));
+        }
+        return table;
+    }
+
+    const Table& getSrgbToLinear()
+    {
+        static const Table s_table = makeTable(true);
+        return s_table;
+    }
+
+    const Table& getLinearToSrgb()
+    {
+        static const Table s_table = makeTable(false);
+        return s_table;
+    }
+
+    void expandGrayScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        for (size_t i = 0; i < nPixels; ++i)
+        {
+            pDst[i * 4 + 0] = pDst[i * 4 + 1] = pDst[i * 4 + 2] = pSrc[i];
+            pDst[i * 4 + 3] = 255;
+        }
+    }
+
+    void expandGrayAlphaScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        for (size_t i = 0; i < nPixels; ++i)
+        {
+            pDst[i * 4 + 0] = pDst[i * 4 + 1] = pDst[i * 4 + 2] = pSrc[i * 2];
+            pDst[i * 4 + 3] = pSrc[i * 2 + 1];
+        }
+    }
+
+    void expandRGBScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        for (size_t i = 0; i < nPixels; ++i)
+        {
+            pDst[i * 4 + 0] = pSrc[i * 3 + 0];
+            pDst[i * 4 + 1] = pSrc[i * 3 + 1];
+            pDst[i * 4 + 2] = pSrc[i * 3 + 2];
+            pDst[i * 4 + 3] = 255;
+        }
+    }
+
+    void swizzleRBScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        for (size_t i = 0; i < nPixels; ++i)
+        {
+            uint8_t r = pSrc[i * 4 + 0], g = pSrc[i * 4 + 1], b = pSrc[i * 4 + 2], a = pSrc[i * 4 + 3];
+            pDst[i * 4 + 0] = b;
+            pDst[i * 4 + 1] = g;
+            pDst[i * 4 + 2] = r;
+            pDst[i * 4 + 3] = a;
+        }
+    }
+
+    void premultiplyAlphaScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        for (size_t i = 0; i < nPixels; ++i)
+        {
+            uint32_t a = pSrc[i * 4 + 3];
+            pDst[i * 4 + 0] = mulDiv255(pSrc[i * 4 + 0], a);
+            pDst[i * 4 + 1] = mulDiv255(pSrc[i * 4 + 1], a);
+            pDst[i * 4 + 2] = mulDiv255(pSrc[i * 4 + 2], a);
+            pDst[i * 4 + 3] = uint8_t(a);
+        }
+    }
+
+    void applyTableScalar(const Table& table, const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        for (size_t i = 0; i < nPixels; ++i)
+        {
+            pDst[i * 4 + 0] = table[pSrc[i * 4 + 0]];
+            pDst[i * 4 + 1] = table[pSrc[i * 4 + 1]];
+            pDst[i * 4 + 2] = table[pSrc[i * 4 + 2]];
+            pDst[i * 4 + 3] = pSrc[i * 4 + 3];
+        }
+    }
+
+    void srgbToLinearScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        applyTableScalar(getSrgbToLinear(), pSrc, pDst, nPixels);
+    }
+
+    void linearToSrgbScalar(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        applyTableScalar(getLinearToSrgb(), pSrc, pDst, nPixels);
+    }
+
+#if PIXELKERNELS_X86
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void expandGraySSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        // pixels 0 - 3 of the load, the masks of the other quarters are offset by 4. the unused lanes stay
+        // negative, which zeroes them
+        const __m128i mask = _mm_setr_epi8(0, 0, 0, -128, 1, 1, 1, -128, 2, 2, 2, -128, 3, 3, 3, -128);
+        const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+        size_t i = 0;
+        for ( ; i + 16 <= nPixels; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+            for (int k = 0; k < 4; ++k)
+            {
+                __m128i quarter = _mm_shuffle_epi8(v, _mm_add_epi8(mask, _mm_set1_epi8(char(4 * k))));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + (i + 4 * k) * 4), _mm_or_si128(quarter, alpha));
+            }
+        }
+        expandGrayScalar(pSrc + i, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void expandGrayAlphaSSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        const __m128i mask = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+        const __m128i offset = _mm_set1_epi8(8);
+        size_t i = 0;
+        for ( ; i + 8 <= nPixels; i += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 2));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_shuffle_epi8(v, mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4 + 16), _mm_shuffle_epi8(v, _mm_add_epi8(mask, offset)));
+        }
+        expandGrayAlphaScalar(pSrc + i * 2, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void expandRGBSSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+        size_t i = 0;
+        // the loads take 16 bytes for 4 pixels - the last 4 bytes have to be inside the source too
+        for ( ; i + 6 <= nPixels; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+        }
+        expandRGBScalar(pSrc + i * 3, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void swizzleRBSSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        size_t i = 0;
+        for ( ; i + 4 <= nPixels; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_shuffle_epi8(v, mask));
+        }
+        swizzleRBScalar(pSrc + i * 4, pDst + i * 4, nPixels - i);
+    }
+
+    // 2 pixels of 16-bit channels: x * a / 255 with the alpha of the pixel (255 for the alpha channel itself)
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    inline __m128i premultiply2SSE4(__m128i v)
+    {
+        const __m128i alphaMask = _mm_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+        const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+        const __m128i round = _mm_set1_epi16(128);
+        __m128i a = _mm_or_si128(_mm_shuffle_epi8(v, alphaMask), alphaOne);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), round);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void premultiplyAlphaSSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        size_t i = 0;
+        for ( ; i + 4 <= nPixels; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+            __m128i lo = premultiply2SSE4(_mm_cvtepu8_epi16(v));
+            __m128i hi = premultiply2SSE4(_mm_unpackhi_epi8(v, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+        premultiplyAlphaScalar(pSrc + i * 4, pDst + i * 4, nPixels - i);
+    }
+
+    // the table is 16 rows of 16 entries: every row is a byte shuffle by the low nibble, the high nibble
+    // picks the row
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void applyTableSSE4(const Table& table, const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+        size_t i = 0;
+        for ( ; i + 4 <= nPixels; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+            __m128i lo = _mm_and_si128(v, nibble);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+            __m128i result = _mm_setzero_si128();
+            for (int k = 0; k < 16; ++k)
+            {
+                __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data() + k * 16));
+                __m128i match = _mm_cmpeq_epi8(hi, _mm_set1_epi8(char(k)));
+                result = _mm_or_si128(result, _mm_and_si128(_mm_shuffle_epi8(row, lo), match));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_blendv_epi8(result, v, alpha));
+        }
+        applyTableScalar(table, pSrc + i * 4, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void srgbToLinearSSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        applyTableSSE4(getSrgbToLinear(), pSrc, pDst, nPixels);
+    }
+
+    PIXELKERNELS_TARGET("ssse3,sse4.1")
+    void linearToSrgbSSE4(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        applyTableSSE4(getLinearToSrgb(), pSrc, pDst, nPixels);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void expandRGBAVX2(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        // 24 bytes of 8 pixels: bytes 0-15 go to the low lane, bytes 12-27 to the high one
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+        const __m256i mask = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+        size_t i = 0;
+        // the loads take 32 bytes for 8 pixels
+        for ( ; i + 11 <= nPixels; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 3));
+            v = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(v, lanes), mask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), _mm256_or_si256(v, alpha));
+        }
+        expandRGBSSE4(pSrc + i * 3, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void swizzleRBAVX2(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        size_t i = 0;
+        for ( ; i + 8 <= nPixels; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), _mm256_shuffle_epi8(v, mask));
+        }
+        swizzleRBSSE4(pSrc + i * 4, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    inline __m256i premultiply4AVX2(__m256i v)
+    {
+        const __m256i alphaMask = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1,
+            6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+        const __m256i alphaOne = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+        const __m256i round = _mm256_set1_epi16(128);
+        __m256i a = _mm256_or_si256(_mm256_shuffle_epi8(v, alphaMask), alphaOne);
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(v, a), round);
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void premultiplyAlphaAVX2(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        size_t i = 0;
+        for ( ; i + 8 <= nPixels; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 4));
+            __m256i lo = premultiply4AVX2(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+            __m256i hi = premultiply4AVX2(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+            // the pack interleaves the lanes of both halves - put the quarters back in order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), packed);
+        }
+        premultiplyAlphaSSE4(pSrc + i * 4, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void applyTableAVX2(const Table& table, const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+        size_t i = 0;
+        for ( ; i + 8 <= nPixels; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 4));
+            __m256i lo = _mm256_and_si256(v, nibble);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+            __m256i result = _mm256_setzero_si256();
+            for (int k = 0; k < 16; ++k)
+            {
+                // the shuffle stays within 128-bit lanes - both get the row
+                __m256i row = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data() + k * 16)));
+                __m256i match = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8(char(k)));
+                result = _mm256_or_si256(result, _mm256_and_si256(_mm256_shuffle_epi8(row, lo), match));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), _mm256_blendv_epi8(result, v, alpha));
+        }
+        applyTableSSE4(table, pSrc + i * 4, pDst + i * 4, nPixels - i);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void srgbToLinearAVX2(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        applyTableAVX2(getSrgbToLinear(), pSrc, pDst, nPixels);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void linearToSrgbAVX2(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+    {
+        applyTableAVX2(getLinearToSrgb(), pSrc, pDst, nPixels);
+    }
+
+    PixelKernels::eLevel detectLevel()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4];
+        __cpuid(regs, 0);
+        int nMaxLeaf = regs[0];
+        __cpuid(regs, 1);
+        bool bSSE4 = (regs[2] & (1 << 9)) && (regs[2] & (1 << 19));  // SSSE3, SSE4.1
+        // AVX2 also needs the OS to save the ymm registers
+        bool bAVX = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        bool bAVX2 = false;
+        if (bAVX && nMaxLeaf >= 7)
+        {
+            __cpuidex(regs, 7, 0);
+            bAVX2 = (regs[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool bSSE4 = __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+        bool bAVX2 = __builtin_cpu_supports("avx2");
+#endif
+        return bAVX2 ? PixelKernels::eLevelAVX2 : bSSE4 ? PixelKernels::eLevelSSE4 : PixelKernels::eLevelScalar;
+    }
+
+    // the gray expansions are bound by their stores - the SSE versions serve the AVX2 level as well
+    const Kernels s_kernels[] =
+    {
+        { expandGrayScalar, expandGrayAlphaScalar, expandRGBScalar,
+            swizzleRBScalar, premultiplyAlphaScalar, srgbToLinearScalar, linearToSrgbScalar },
+        { expandGraySSE4, expandGrayAlphaSSE4, expandRGBSSE4,
+            swizzleRBSSE4, premultiplyAlphaSSE4, srgbToLinearSSE4, linearToSrgbSSE4 },
+        { expandGraySSE4, expandGrayAlphaSSE4, expandRGBAVX2,
+            swizzleRBAVX2, premultiplyAlphaAVX2, srgbToLinearAVX2, linearToSrgbAVX2 }
+    };
+#else
+    PixelKernels::eLevel detectLevel()
+    {
+        return PixelKernels::eLevelScalar;
+    }
+
+    const Kernels s_kernels[] =
+    {
+        { expandGrayScalar, expandGrayAlphaScalar, expandRGBScalar,
+            swizzleRBScalar, premultiplyAlphaScalar, srgbToLinearScalar, linearToSrgbScalar }
+    };
+#endif
+
+    // -1 until the first kernel runs
+    std::atomic<int> s_nLevel = -1;
+
+    const Kernels& getKernels()
+    {
+        int nLevel = s_nLevel.load(std::memory_order_relaxed);
+        if (nLevel < 0)
+        {
+            nLevel = int(detectLevel());
+            s_nLevel.store(nLevel, std::memory_order_relaxed);
+        }
+        return s_kernels[nLevel];
+    }
+}
+
+PixelKernels::eLevel PixelKernels::getLevel()
+{
+    getKernels();
+    return eLevel(s_nLevel.load(std::memory_order_relaxed));
+}
+
+void PixelKernels::setLevel(eLevel eMaxLevel)
+{
+    s_nLevel.store(std::min(int(eMaxLevel), int(detectLevel())), std::memory_order_relaxed);
+}
+
+void PixelKernels::expandToRGBA(const uint8_t* pSrc, uint32_t nChannels, uint8_t* pDst, size_t nPixels)
+{
+    switch (nChannels)
+    {
+    case 1:
+        getKernels().m_pExpandGray(pSrc, pDst, nPixels);
+        break;
+    case 2:
+        getKernels().m_pExpandGrayAlpha(pSrc, pDst, nPixels);
+        break;
+    case 3:
+        getKernels().m_pExpandRGB(pSrc, pDst, nPixels);
+        break;
+    case 4:
+        memcpy(pDst, pSrc, nPixels * 4);
+        break;
+    default:
+        assert(false && "Unsupported number of channels");
+        break;
+    }
+}
+
+void PixelKernels::swizzleRB(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+{
+    getKernels().m_pSwizzleRB(pSrc, pDst, nPixels);
+}
+
+void PixelKernels::premultiplyAlpha(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+{
+    getKernels().m_pPremultiplyAlpha(pSrc, pDst, nPixels);
+}
+
+void PixelKernels::srgbToLinear(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+{
+    getKernels().m_pSrgbToLinear(pSrc, pDst, nPixels);
+}
+
+void PixelKernels::linearToSrgb(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels)
+{
+    getKernels().m_pLinearToSrgb(pSrc, pDst, nPixels);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// pixel conversion kernels for 8-bit images. the implementation is picked once for the CPU at hand (AVX2,
+// SSE4.1 or scalar). the kernels write straight into pDst, so a conversion and the copy to its destination
+// are one pass over the pixels
+struct PixelKernels
+{
+    enum eLevel
+    {
+        eLevelScalar = 0,
+        eLevelSSE4 = 1,
+        eLevelAVX2 = 2
+    };
+    static eLevel getLevel();
+    // switches to a lower level, e.g. to compare the implementations. levels the CPU lacks are clamped
+    static void setLevel(eLevel eMaxLevel);
+
+    // gray, gray + alpha, RGB or RGBA (nChannels 1 - 4) -> RGBA8, missing alpha is opaque. pSrc and pDst
+    // don't overlap
+    static void expandToRGBA(const uint8_t* pSrc, uint32_t nChannels, uint8_t* pDst, size_t nPixels);
+    // the RGBA8 kernels below can work in place (pSrc == pDst)
+    // RGBA8 <-> BGRA8
+    static void swizzleRB(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels);
+    // the alpha channel is kept
+    static void premultiplyAlpha(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels);
+    // through 256-entry tables, the alpha channel is kept
+    static void srgbToLinear(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels);
+    static void linearToSrgb(const uint8_t* pSrc, uint8_t* pDst, size_t nPixels);
+};
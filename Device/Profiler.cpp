@@ -0,0 +1,83 @@
+#include "framework.h"
+#include "Profiler.h"
+#include <cassert>
+
+Profiler::Profiler(const uint64_t* pTimestamps, uint64_t nFrequency)
+    : m_pTimestamps(pTimestamps)
+    , m_nFrequency(nFrequency)
+{
+    assert(pTimestamps && nFrequency && "Profiler needs timestamp storage and frequency");
+    m_freeSlots.resize(s_nMaxTimestamps);
+    for (uint32_t u = 0; u < s_nMaxTimestamps; ++u)
+    {
+        m_freeSlots[u] = s_nMaxTimestamps - 1 - u;
+    }
+}
+
+uint32_t Profiler::allocateTimestamp()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_freeSlots.empty())
+        return s_nInvalidSlot;
+    uint32_t uSlot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return uSlot;
+}
+
+void Profiler::onExecuted(std::vector<Scope>& scopes, uint64_t fenceValue)
+{
+    if (scopes.empty())
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Submission submission;
+    submission.m_fenceValue = fenceValue;
+    submission.m_scopes.swap(scopes);
+    m_submissions.push_back(std::move(submission));
+}
+
+void Profiler::release(const std::vector<Scope>& scopes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        releaseSlots(*it);
+    }
+}
+
+void Profiler::releaseSlots(const Scope& scope)
+{
+    // the slots go back next to each other, so that lists mostly get runs of consecutive slots (see
+    // D3D12CmdList::resolveTimestamps())
+    if (scope.m_uEnd != s_nInvalidSlot)
+        m_freeSlots.push_back(scope.m_uEnd);
+    if (scope.m_uBegin != s_nInvalidSlot)
+        m_freeSlots.push_back(scope.m_uBegin);
+}
+
+std::unordered_map<std::string, double> Profiler::collect(uint64_t landedValue)
+{
+    std::unordered_map<std::string, double> durations;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (!m_submissions.empty() && m_submissions.front().m_fenceValue <= landedValue)
+    {
+        auto& submission = m_submissions.front();
+        for (auto& scope : submission.m_scopes)
+        {
+            // scopes that ran out of slots are not measured
+            if (scope.m_uBegin == s_nInvalidSlot || scope.m_uEnd == s_nInvalidSlot)
+                continue;
+            uint64_t nBegin = m_pTimestamps[scope.m_uBegin];
+            uint64_t nEnd = m_pTimestamps[scope.m_uEnd];
+            // the clocks of some devices are not monotonic across power state changes
+            double fMs = nEnd > nBegin ? double(nEnd - nBegin) * 1000.0 / double(m_nFrequency) : 0.0;
+            durations[scope.m_sName] += fMs;
+        }
+        for (auto it = submission.m_scopes.rbegin(); it != submission.m_scopes.rend(); ++it)
+        {
+            releaseSlots(*it);
+        }
+        m_submissions.pop_front();
+    }
+    return durations;
+}
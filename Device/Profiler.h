@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// timestamps of the profiling scopes recorded on a queue (see ICmdList::beginScope()). the timestamps are
+// written by the backend into m_pTimestamps (s_nMaxTimestamps of them, in ticks of m_nFrequency) and are
+// turned into durations once the command list that wrote them has landed
+class Profiler
+{
+public:
+    static constexpr uint32_t s_nMaxTimestamps = 4096;
+    static constexpr uint32_t s_nInvalidSlot = UINT32_MAX;
+
+    struct Scope
+    {
+        std::string m_sName;
+        uint32_t m_uBegin = s_nInvalidSlot, m_uEnd = s_nInvalidSlot;
+    };
+
+    Profiler(const uint64_t* pTimestamps, uint64_t nFrequency);
+
+    // s_nInvalidSlot if all slots are in use - the scope is not measured then
+    uint32_t allocateTimestamp();
+    // called by the queue for every executed command list: takes the scopes of the list, their slots are
+    // released once fenceValue has landed and collect() has read them
+    void onExecuted(std::vector<Scope>& scopes, uint64_t fenceValue);
+    // releases the slots of the scopes of a list that was dropped without being executed
+    void release(const std::vector<Scope>& scopes);
+
+    // durations (ms) of the scopes whose command lists reached landedValue since the previous call, summed by name
+    std::unordered_map<std::string, double> collect(uint64_t landedValue);
+
+private:
+    struct Submission
+    {
+        uint64_t m_fenceValue = 0;
+        std::vector<Scope> m_scopes;
+    };
+    // gives the slots of the scope back, called with m_mutex locked
+    void releaseSlots(const Scope& scope);
+
+    const uint64_t* m_pTimestamps = nullptr;
+    uint64_t m_nFrequency = 0;
+
+    std::mutex m_mutex;
+    // handed out from the back
+    std::vector<uint32_t> m_freeSlots;
+    // in the order of the fence values
+    std::deque<Submission> m_submissions;
+};
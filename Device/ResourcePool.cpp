@@ -0,0 +1,83 @@
+#include "framework.h"
+#include "ResourcePool.h"
+#include "IDevice.h"
+#include <cassert>
+
+std::shared_ptr<IResource> ResourcePool::allocate(IDevice* pDevice, const IResource::ResDesc& desc)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_buckets.find(desc);
+        if (it != m_buckets.end())
+        {
+            auto& entries = it->second;
+            // the oldest entries are the most likely to have landed
+            for (size_t u = 0; u < entries.size(); ++u)
+            {
+                if (entries[u].isAvailable())
+                {
+                    auto pResource = std::move(entries[u].m_pResource);
+                    entries.erase(entries.begin() + u);
+                    return pResource;
+                }
+            }
+        }
+    }
+    return pDevice->createResource(desc);
+}
+
+void ResourcePool::release(IDevice* pDevice, std::shared_ptr<IResource> pResource, std::shared_ptr<IFence> pFence, uint64_t fenceValue)
+{
+    if (!pResource)
+        return;
+
+    IResource::ResDesc desc;
+    pResource->getDesc(desc);
+
+    Entry evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& entries = m_buckets[desc];
+        if (entries.size() >= m_nMaxResourcesPerDesc)
+        {
+            evicted = std::move(entries.front());
+            entries.erase(entries.begin());
+        }
+        Entry entry;
+        entry.m_pResource = std::move(pResource);
+        entry.m_pFence = std::move(pFence);
+        entry.m_fenceValue = fenceValue;
+        entries.push_back(std::move(entry));
+    }
+
+    // the evicted resource may still be in use - destroy it only after its last use
+    if (evicted.m_pResource)
+    {
+        pDevice->retire(std::move(evicted.m_pResource), FenceTicket{ std::move(evicted.m_pFence), evicted.m_fenceValue });
+    }
+}
+
+void ResourcePool::trim()
+{
+    std::vector<Entry> trimmed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& bucket : m_buckets)
+        {
+            auto& entries = bucket.second;
+            for (size_t u = 0; u < entries.size(); )
+            {
+                if (entries[u].isAvailable())
+                {
+                    trimmed.push_back(std::move(entries[u]));
+                    entries.erase(entries.begin() + u);
+                }
+                else
+                {
+                    ++u;
+                }
+            }
+        }
+    }
+    // resources are destroyed outside of the lock
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "IResource.h"
+#include "IFence.h"
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+struct IDevice;
+
+// recycles released resources: a resource handed back with release() is returned by allocate()
+// for an identical ResDesc once the fence of its last use has landed
+class ResourcePool
+{
+public:
+    std::shared_ptr<IResource> allocate(IDevice* pDevice, const IResource::ResDesc& desc);
+    // pFence may be null if the resource is not referenced by any in-flight work. a resource evicted from a
+    // full bucket is handed to IDevice::retire() with its ticket, so release() never blocks
+    void release(IDevice* pDevice, std::shared_ptr<IResource> pResource, std::shared_ptr<IFence> pFence, uint64_t fenceValue);
+    // drops all pooled resources whose last use has landed
+    void trim();
+
+    // limits the number of pooled resources with the same desc
+    void setMaxResourcesPerDesc(uint32_t nMax) { m_nMaxResourcesPerDesc = nMax; }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<IResource> m_pResource;
+        std::shared_ptr<IFence> m_pFence;
+        uint64_t m_fenceValue = 0;
+
+        bool isAvailable() const { return !m_pFence || m_pFence->getLastLandedValue() >= m_fenceValue; }
+    };
+
+    std::mutex m_mutex;
+    // entries in each bucket are ordered from the oldest to the most recently released
+    std::unordered_map<IResource::ResDesc, std::vector<Entry>> m_buckets;
+    uint32_t m_nMaxResourcesPerDesc = 8;
+};
@@ -0,0 +1,145 @@
+#include "framework.h"
+#include "RetireQueue.h"
+#include "IDevice.h"
+#include <algorithm>
+
+RetireQueue::~RetireQueue()
+{
+    drain(0);
+}
+
+void RetireQueue::retire(std::shared_ptr<void> pObject, const FenceTicket& ticket)
+{
+    if (ticket.isReady())
+        return;  // nothing in flight - pObject goes away right here
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_bExit)
+        {
+            if (!m_thread.joinable())
+            {
+                m_pWakeFence = m_pDevice->createFence();
+                m_thread = std::thread(&RetireQueue::threadFunc, this);
+            }
+            m_entries.push_back(Entry{ std::move(pObject), ticket });
+            if (m_bWaiting)
+            {
+                // the thread waits for the fences of the entries it knew about - make it pick up this one
+                m_bWaiting = false;
+                m_pWakeFence->signalCpuFence(++m_wakeValue);
+            }
+            m_cv.notify_one();
+            return;
+        }
+    }
+    // already drained - nobody is left to release the object later
+    ticket.waitCpu(s_nDrainTimeoutMs);
+}
+
+void RetireQueue::drain(uint32_t nTimeoutMs)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bExit = true;
+        if (m_bWaiting)
+        {
+            m_bWaiting = false;
+            m_pWakeFence->signalCpuFence(++m_wakeValue);
+        }
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    m_pWakeFence = nullptr;
+
+    // the thread is gone, the entries are only touched here now
+    std::vector<FenceTicket> tickets;
+    for (auto& entry : m_entries)
+    {
+        // a value that was never signalled does not land in any time
+        if (entry.m_ticket.m_value > entry.m_ticket.m_pFence->getLastSignalledValue())
+            continue;
+        // the highest value of each fence covers the others
+        auto it = std::find_if(tickets.begin(), tickets.end(),
+            [&entry](const FenceTicket& t) { return t.m_pFence == entry.m_ticket.m_pFence; });
+        if (it == tickets.end())
+        {
+            tickets.push_back(entry.m_ticket);
+        }
+        else
+        {
+            it->m_value = std::max(it->m_value, entry.m_ticket.m_value);
+        }
+    }
+    // what did not land in time is released anyway - the GPU is not going to get there
+    if (nTimeoutMs > 0)
+    {
+        IFence::waitAll(tickets, nTimeoutMs);
+    }
+    m_entries.clear();
+}
+
+void RetireQueue::threadFunc()
+{
+    std::vector<std::shared_ptr<void>> pLanded;
+    std::vector<FenceTicket> tickets;
+    for ( ; ; )
+    {
+        tickets.clear();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_bExit || !m_entries.empty(); });
+            // drain() releases what is left
+            if (m_bExit)
+                return;
+
+            size_t nKept = 0;
+            for (auto& entry : m_entries)
+            {
+                if (entry.m_ticket.isReady())
+                {
+                    pLanded.push_back(std::move(entry.m_pObject));
+                    continue;
+                }
+                // the fence values land in order - the lowest pending value of each fence is enough to wait for.
+                // values that are not signalled yet (collected by a queue in deferred mode) are not waited for, that
+                // would submit the collected lists from this thread - they are checked again on the next wake-up
+                if (entry.m_ticket.m_value > entry.m_ticket.m_pFence->getLastSignalledValue())
+                {
+                    m_entries[nKept++] = std::move(entry);
+                    continue;
+                }
+                auto it = std::find_if(tickets.begin(), tickets.end(),
+                    [&entry](const FenceTicket& t) { return t.m_pFence == entry.m_ticket.m_pFence; });
+                if (it == tickets.end())
+                {
+                    tickets.push_back(entry.m_ticket);
+                }
+                else
+                {
+                    it->m_value = std::min(it->m_value, entry.m_ticket.m_value);
+                }
+                m_entries[nKept++] = std::move(entry);
+            }
+            m_entries.resize(nKept);
+            if (pLanded.empty())
+            {
+                tickets.push_back(FenceTicket{ m_pWakeFence, m_wakeValue + 1 });
+                m_bWaiting = true;
+            }
+        }
+
+        // destructors run outside of the lock, the whole batch at once
+        if (!pLanded.empty())
+        {
+            pLanded.clear();
+            continue;
+        }
+
+        IFence::waitAny(tickets);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bWaiting = false;
+    }
+}
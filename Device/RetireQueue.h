@@ -0,0 +1,53 @@
+#pragma once
+
+#include "IFence.h"
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct IDevice;
+
+// keeps objects alive until the GPU is done with them - an object handed to retire() is released once its
+// ticket lands. landed objects are released in batches on a background thread, so nobody has to flush a
+// queue just to protect the lifetime of what it reads
+class RetireQueue
+{
+public:
+    // the wait of drain() in the destructors of the devices
+    static constexpr uint32_t s_nDrainTimeoutMs = 5000;
+
+    // the wake-up fence of the thread is created on pDevice
+    explicit RetireQueue(IDevice* pDevice) : m_pDevice(pDevice) {}
+    // releases what drain() did not - without waiting
+    ~RetireQueue();
+    RetireQueue(const RetireQueue&) = delete;
+    RetireQueue& operator=(const RetireQueue&) = delete;
+
+    void retire(std::shared_ptr<void> pObject, const FenceTicket& ticket);
+    // called by the destructor of the device, while the objects can still be released: stops the thread, waits up
+    // to nTimeoutMs for the pending tickets and then releases everything - also what did not land, e.g. because
+    // the device was lost. objects retired afterwards are released right away
+    void drain(uint32_t nTimeoutMs);
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<void> m_pObject;
+        FenceTicket m_ticket;
+    };
+    void threadFunc();
+
+    IDevice* m_pDevice = nullptr;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Entry> m_entries;
+    bool m_bExit = false;
+    // signalled from the CPU by retire() and drain() while the thread waits for the fences of the entries
+    std::shared_ptr<IFence> m_pWakeFence;
+    uint64_t m_wakeValue = 0;
+    bool m_bWaiting = false;
+    // started by the first retire()
+    std::thread m_thread;
+};
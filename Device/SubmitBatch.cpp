@@ -0,0 +1,39 @@
+#include "framework.h"
+#include "SubmitBatch.h"
+#include <cassert>
+
+SubmitBatch::SubmitBatch(std::shared_ptr<IQueue> pQueue, uint32_t nSlots)
+    : m_pQueue(std::move(pQueue))
+    , m_pSlots(nSlots)
+{
+    assert(m_pQueue && nSlots > 0 && "Batch needs a queue and at least one slot");
+    m_pRecorded.reserve(nSlots);
+}
+
+ICmdList* SubmitBatch::startRecording(uint32_t uSlot)
+{
+    assert(uSlot < m_pSlots.size() && "Slot out of range");
+    assert(!m_pSlots[uSlot] && "Slot is recorded already");
+    // the list comes from the pool of the calling thread, so slots are recorded without contention
+    m_pSlots[uSlot] = m_pQueue->startRecording();
+    return m_pSlots[uSlot].get();
+}
+
+FenceTicket SubmitBatch::submit()
+{
+    m_pRecorded.clear();
+    for (auto& pSlot : m_pSlots)
+    {
+        if (pSlot)
+        {
+            m_pRecorded.push_back(std::move(pSlot));
+            pSlot = nullptr;
+        }
+    }
+    if (m_pRecorded.empty())
+        return FenceTicket();
+    FenceTicket ticket = m_pQueue->execute(m_pRecorded);
+    // the queue keeps the lists alive until they are executed - release them here so that they go back to the pools
+    m_pRecorded.clear();
+    return ticket;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "IQueue.hpp"
+#include <memory>
+#include <vector>
+
+// one submission recorded by several threads: every thread records into its own slot with a command list
+// from its own pool, submit() executes the slots in slot order with a single fence signal. the order of
+// the work on the queue does not depend on which thread finished recording first
+class SubmitBatch
+{
+public:
+    SubmitBatch(std::shared_ptr<IQueue> pQueue, uint32_t nSlots);
+
+    // called by the thread that records uSlot - a slot is recorded by one thread at a time
+    ICmdList* startRecording(uint32_t uSlot);
+    // called once all slots are recorded. slots nobody recorded are skipped, the batch can be reused after
+    FenceTicket submit();
+
+    uint32_t getSlotCount() const { return uint32_t(m_pSlots.size()); }
+
+private:
+    std::shared_ptr<IQueue> m_pQueue;
+    std::vector<std::shared_ptr<ICmdList>> m_pSlots;
+    // scratch array of the recorded slots
+    std::vector<std::shared_ptr<ICmdList>> m_pRecorded;
+};
@@ -0,0 +1,203 @@
+#include "framework.h"
+#include "TextureCache.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t s_nCacheMagic = 0x43574152;  // "RAWC"
+    constexpr uint32_t s_nCacheVersion = 2;
+
+    bool getSourceStamp(const std::filesystem::path& sSource, uint64_t& nSize, int64_t& mtime)
+    {
+        std::error_code ec;
+        nSize = std::filesystem::file_size(sSource, ec);
+        if (ec)
+            return false;
+        auto writeTime = std::filesystem::last_write_time(sSource, ec);
+        if (ec)
+            return false;
+        mtime = int64_t(writeTime.time_since_epoch().count());
+        return true;
+    }
+
+    // several processes and threads may write the same cache - each writer gets a temporary file of its own
+    std::filesystem::path getTempPath(const std::filesystem::path& sCache)
+    {
+        static std::atomic<uint32_t> s_nNextTemp = 0;
+#ifdef _WIN32
+        unsigned long nProcess = GetCurrentProcessId();
+#else
+        unsigned long nProcess = (unsigned long)getpid();
+#endif
+        char sSuffix[48];
+        snprintf(sSuffix, sizeof(sSuffix), ".%lu.%u.tmp", nProcess, s_nNextTemp++);
+        std::filesystem::path sTmp = sCache;
+        sTmp += sSuffix;
+        return sTmp;
+    }
+}
+
+std::filesystem::path TextureCache::getCachePath(const std::filesystem::path& sSource)
+{
+    std::filesystem::path sCache = sSource;
+    sCache += ".rawcache";
+    return sCache;
+}
+
+bool TextureCache::write(const std::filesystem::path& sSource, uint32_t nWidth, uint32_t nHeight,
+    IResource::eFormat format, uint32_t nRowPitch, const uint8_t* pPixels, uint32_t nMips)
+{
+    assert((nMips == 1 || nRowPitch == IResource::getPackedRowPitch(format, nWidth)) && "Mip chains have tightly packed rows");
+    Header header;
+    header.m_magic = s_nCacheMagic;
+    header.m_version = s_nCacheVersion;
+    header.m_nWidth = nWidth;
+    header.m_nHeight = nHeight;
+    header.m_format = format;
+    header.m_nRowPitch = nRowPitch;
+    header.m_nMips = nMips;
+    if (!getSourceStamp(sSource, header.m_nSourceSize, header.m_sourceMTime))
+        return false;
+
+    // write into a temporary file and rename it, so that a concurrent reader never maps a partial cache
+    std::filesystem::path sCache = getCachePath(sSource);
+    std::filesystem::path sTmp = getTempPath(sCache);
+    FILE* fp = fopen(sTmp.string().c_str(), "wb");
+    if (!fp)
+        return false;
+    size_t nPixelBytes = nMips > 1 ? MipChain::getLevelOffset(format, nWidth, nHeight, nMips) :
+        size_t(nRowPitch) * IResource::getBlockRows(format, nHeight);
+    bool bSucceeded = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(pPixels, 1, nPixelBytes, fp) == nPixelBytes;
+    bSucceeded = (fclose(fp) == 0) && bSucceeded;
+
+    std::error_code ec;
+    if (bSucceeded)
+    {
+        std::filesystem::rename(sTmp, sCache, ec);
+        bSucceeded = !ec;
+    }
+    if (!bSucceeded)
+    {
+        std::filesystem::remove(sTmp, ec);
+    }
+    return bSucceeded;
+}
+
+TextureCache::MappedImage::~MappedImage()
+{
+    close();
+}
+
+bool TextureCache::MappedImage::open(const std::filesystem::path& sSource)
+{
+    close();
+
+    uint64_t nSourceSize = 0;
+    int64_t sourceMTime = 0;
+    if (!getSourceStamp(sSource, nSourceSize, sourceMTime))
+        return false;
+
+    std::filesystem::path sCache = getCachePath(sSource);
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(sCache.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+    m_hFile = hFile;
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart < LONGLONG(sizeof(Header)))
+    {
+        close();
+        return false;
+    }
+    m_hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_hMapping)
+    {
+        close();
+        return false;
+    }
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    m_nSize = size_t(size.QuadPart);
+#else
+    int fd = ::open(sCache.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        return false;
+    }
+    void* pData = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (pData == MAP_FAILED)
+        return false;
+    // the pixels are read once, front to back. advice values are not flags - one call each. they are only hints,
+    // a failure leaves the mapping usable
+    int nSequential = madvise(pData, size_t(st.st_size), MADV_SEQUENTIAL);
+    int nWillNeed = madvise(pData, size_t(st.st_size), MADV_WILLNEED);
+    assert(nSequential == 0 && nWillNeed == 0 && "madvise failed");
+    (void)nSequential;
+    (void)nWillNeed;
+    m_pData = static_cast<const uint8_t*>(pData);
+    m_nSize = size_t(st.st_size);
+#endif
+    if (!m_pData)
+    {
+        close();
+        return false;
+    }
+
+    const Header& header = getHeader();
+    auto format = IResource::eFormat(header.m_format);
+    bool bValid = header.m_magic == s_nCacheMagic && header.m_version == s_nCacheVersion &&
+        header.m_nSourceSize == nSourceSize && header.m_sourceMTime == sourceMTime &&
+        header.m_nRowPitch >= IResource::getPackedRowPitch(format, header.m_nWidth) &&
+        header.m_nMips >= 1 && header.m_nMips <= MipChain::getFullCount(header.m_nWidth, header.m_nHeight) &&
+        (header.m_nMips == 1 || header.m_nRowPitch == IResource::getPackedRowPitch(format, header.m_nWidth)) &&
+        m_nSize >= sizeof(Header) + std::max(uint64_t(header.m_nRowPitch) * IResource::getBlockRows(format, header.m_nHeight),
+            uint64_t(MipChain::getLevelOffset(format, header.m_nWidth, header.m_nHeight, header.m_nMips)));
+    if (!bValid)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TextureCache::MappedImage::close()
+{
+#ifdef _WIN32
+    if (m_pData)
+        UnmapViewOfFile(m_pData);
+    if (m_hMapping)
+        CloseHandle(m_hMapping);
+    if (m_hFile)
+        CloseHandle(m_hFile);
+    m_hMapping = nullptr;
+    m_hFile = nullptr;
+#else
+    if (m_pData)
+        munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+#endif
+    m_pData = nullptr;
+    m_nSize = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "IResource.h"
+#include <filesystem>
+#include <cstdint>
+
+// decoded images cached on disk next to their source: "<source>.rawcache" is a Header followed by
+// the pixel rows (rows of blocks for the block-compressed formats) - and the other mips, laid out by MipChain.
+// the cache is valid as long as the source has the size and mtime recorded in the header
+struct TextureCache
+{
+    struct Header
+    {
+        uint32_t m_magic = 0;
+        uint32_t m_version = 0;
+        uint32_t m_nWidth = 0, m_nHeight = 0;
+        uint32_t m_format = IResource::eFormatUnknown;
+        uint32_t m_nRowPitch = 0;
+        uint32_t m_nMips = 1;
+        uint64_t m_nSourceSize = 0;
+        int64_t m_sourceMTime = 0;
+    };
+
+    // read-only memory mapping of a valid cache file
+    class MappedImage
+    {
+    public:
+        MappedImage() = default;
+        ~MappedImage();
+        MappedImage(const MappedImage&) = delete;
+        MappedImage& operator=(const MappedImage&) = delete;
+
+        // maps the cache of sSource. false if there is no cache or it is stale
+        bool open(const std::filesystem::path& sSource);
+
+        const Header& getHeader() const { return *reinterpret_cast<const Header*>(m_pData); }
+        const uint8_t* getPixels() const { return m_pData + sizeof(Header); }
+
+    private:
+        void close();
+
+        const uint8_t* m_pData = nullptr;
+        size_t m_nSize = 0;
+#ifdef _WIN32
+        void* m_hFile = nullptr;
+        void* m_hMapping = nullptr;
+#endif
+    };
+
+    static std::filesystem::path getCachePath(const std::filesystem::path& sSource);
+    // writes the cache of sSource. failures (e.g. a read-only media folder) are not fatal - the image
+    // simply gets decoded again next time. chains of several mips have tightly packed rows
+    static bool write(const std::filesystem::path& sSource, uint32_t nWidth, uint32_t nHeight,
+        IResource::eFormat format, uint32_t nRowPitch, const uint8_t* pPixels, uint32_t nMips = 1);
+};
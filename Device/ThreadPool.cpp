@@ -0,0 +1,112 @@
+#include "framework.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(uint32_t nThreads)
+{
+    if (nThreads == 0)
+    {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint32_t u = 0; u < nThreads; ++u)
+    {
+        m_threads.emplace_back(&ThreadPool::threadFunc, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bExit = true;
+    }
+    m_cv.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCv.wait(lock, [this]() { return m_tasks.empty() && m_nRunning == 0; });
+}
+
+void ThreadPool::parallelFor(uint32_t nCount, const std::function<void(uint32_t)>& func)
+{
+    if (nCount == 0)
+        return;
+    // items are claimed from a counter. helpers that start after the last item was claimed return without
+    // touching func, which may be gone by then
+    struct State
+    {
+        std::atomic<uint32_t> m_uNext = 0;
+        uint32_t m_nDone = 0;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+    auto pState = std::make_shared<State>();
+    auto work = [pState, pFunc = &func, nCount]()
+    {
+        for ( ; ; )
+        {
+            uint32_t u = pState->m_uNext.fetch_add(1);
+            if (u >= nCount)
+                return;
+            (*pFunc)(u);
+            {
+                std::lock_guard<std::mutex> lock(pState->m_mutex);
+                ++pState->m_nDone;
+            }
+            pState->m_cv.notify_all();
+        }
+    };
+    uint32_t nHelpers = std::min(getNumThreads(), nCount - 1);
+    for (uint32_t u = 0; u < nHelpers; ++u)
+    {
+        submit(work);
+    }
+    work();
+    std::unique_lock<std::mutex> lock(pState->m_mutex);
+    pState->m_cv.wait(lock, [&]() { return pState->m_nDone == nCount; });
+}
+
+void ThreadPool::threadFunc()
+{
+    Trace::setThreadName("ThreadPool");
+    for ( ; ; )
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_bExit || !m_tasks.empty(); });
+            // remaining tasks are finished before exiting
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_nRunning;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_nRunning;
+        }
+        m_idleCv.notify_all();
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// fixed set of worker threads executing tasks in FIFO order
+class ThreadPool
+{
+public:
+    // nThreads == 0 picks one thread per hardware thread
+    ThreadPool(uint32_t nThreads = 0);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    // blocks until all submitted tasks have finished
+    void waitIdle();
+    // calls func(0) .. func(nCount - 1) on the pool threads and on the calling thread. the caller takes items too and
+    // only waits for items that were started, so tasks of the pool may call this
+    void parallelFor(uint32_t nCount, const std::function<void(uint32_t)>& func);
+
+    uint32_t getNumThreads() const { return uint32_t(m_threads.size()); }
+
+private:
+    void threadFunc();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv, m_idleCv;
+    uint32_t m_nRunning = 0;
+    bool m_bExit = false;
+};
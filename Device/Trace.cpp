@@ -0,0 +1,244 @@
+#include "framework.h"
+#include "Trace.h"
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdio>
+
+std::atomic<bool> Trace::s_bEnabled = false;
+
+namespace {
+    enum eEvent
+    {
+        eEventZone,
+        eEventSpanBegin,
+        eEventSpanEnd,
+        eEventCounter
+    };
+    struct Event
+    {
+        eEvent m_eType;
+        // zone names are string literals, span tracks are interned by the trace
+        const char* m_sName;
+        uint32_t m_uThread;
+        int64_t m_nTimeUs;
+        // duration of a zone, id of a span, value of a counter
+        int64_t m_nValue;
+    };
+    struct PendingSpan
+    {
+        const char* m_sTrack;
+        FenceTicket m_ticket;
+        int64_t m_nId;
+    };
+
+    // the span watcher samples the fences with this period
+    const auto s_spanPollPeriod = std::chrono::microseconds(250);
+
+    struct TraceState
+    {
+        std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+
+        std::mutex m_mutex;
+        std::vector<Event> m_events;
+        std::unordered_map<uint32_t, std::string> m_threadNames;
+        // copies of the span tracks - their owners may go away before the trace is written
+        std::unordered_set<std::string> m_tracks;
+        uint32_t m_nThreads = 0;
+        int64_t m_nSpans = 0;
+
+        std::vector<PendingSpan> m_pendingSpans;
+        std::condition_variable m_spanCv;
+        bool m_bStopWatcher = false;
+        std::thread m_watcher;
+
+        // tracing that was never stopped - the watcher must not outlive the state
+        ~TraceState()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_bStopWatcher = true;
+            }
+            m_spanCv.notify_one();
+            if (m_watcher.joinable())
+            {
+                m_watcher.join();
+            }
+        }
+
+        void add(const Event& event)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_events.push_back(event);
+        }
+    };
+    TraceState& getState()
+    {
+        static TraceState state;
+        return state;
+    }
+
+    uint32_t getThreadIndex()
+    {
+        thread_local uint32_t uThread = UINT32_MAX;
+        if (uThread == UINT32_MAX)
+        {
+            auto& state = getState();
+            std::lock_guard<std::mutex> lock(state.m_mutex);
+            uThread = state.m_nThreads++;
+        }
+        return uThread;
+    }
+
+    void watchSpans()
+    {
+        auto& state = getState();
+        std::unique_lock<std::mutex> lock(state.m_mutex);
+        for ( ; ; )
+        {
+            state.m_spanCv.wait_for(lock, s_spanPollPeriod, [&]() { return state.m_bStopWatcher; });
+            bool bStop = state.m_bStopWatcher;
+
+            // spans still pending when tracing stops end at the stop
+            size_t nKept = 0;
+            for (auto& span : state.m_pendingSpans)
+            {
+                if (bStop || span.m_ticket.isReady())
+                {
+                    int64_t nNowUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - state.m_start).count();
+                    state.m_events.push_back(Event{ eEventSpanEnd, span.m_sTrack, 0, nNowUs, span.m_nId });
+                }
+                else
+                {
+                    state.m_pendingSpans[nKept++] = std::move(span);
+                }
+            }
+            state.m_pendingSpans.resize(nKept);
+            if (bStop)
+                return;
+        }
+    }
+
+    // names in the JSON are written as they are - escape the two characters that would break it
+    void writeString(FILE* fp, const char* s)
+    {
+        fputc('"', fp);
+        for ( ; *s; ++s)
+        {
+            if (*s == '"' || *s == '\\')
+                fputc('\\', fp);
+            fputc(*s, fp);
+        }
+        fputc('"', fp);
+    }
+}
+
+int64_t Trace::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - getState().m_start).count();
+}
+
+void Trace::start()
+{
+    auto& state = getState();
+    {
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        if (s_bEnabled)
+            return;
+        state.m_events.clear();
+        state.m_bStopWatcher = false;
+    }
+    state.m_watcher = std::thread(watchSpans);
+    s_bEnabled = true;
+}
+
+bool Trace::stop(const std::filesystem::path& sPath)
+{
+    auto& state = getState();
+    if (!s_bEnabled.exchange(false))
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        state.m_bStopWatcher = true;
+    }
+    state.m_spanCv.notify_one();
+    state.m_watcher.join();
+
+    FILE* fp = fopen(sPath.string().c_str(), "w");
+    if (!fp)
+        return false;
+
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool bFirst = true;
+    for (auto& [uThread, sName] : state.m_threadNames)
+    {
+        fprintf(fp, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", bFirst ? "" : ",\n", uThread);
+        writeString(fp, sName.c_str());
+        fprintf(fp, "}}");
+        bFirst = false;
+    }
+    for (auto& event : state.m_events)
+    {
+        fprintf(fp, "%s{\"name\":", bFirst ? "" : ",\n");
+        writeString(fp, event.m_sName);
+        switch (event.m_eType)
+        {
+        case eEventZone:
+            fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}", event.m_uThread,
+                (long long)event.m_nTimeUs, (long long)event.m_nValue);
+            break;
+        case eEventSpanBegin:
+        case eEventSpanEnd:
+            fprintf(fp, ",\"cat\":\"queue\",\"ph\":\"%s\",\"pid\":1,\"tid\":0,\"ts\":%lld,\"id\":%lld}",
+                event.m_eType == eEventSpanBegin ? "b" : "e", (long long)event.m_nTimeUs, (long long)event.m_nValue);
+            break;
+        case eEventCounter:
+            fprintf(fp, ",\"ph\":\"C\",\"pid\":1,\"ts\":%lld,\"args\":{\"value\":%lld}}",
+                (long long)event.m_nTimeUs, (long long)event.m_nValue);
+            break;
+        }
+        bFirst = false;
+    }
+    fprintf(fp, "\n]}\n");
+    state.m_events.clear();
+    return fclose(fp) == 0;
+}
+
+void Trace::setThreadName(const char* sName)
+{
+    uint32_t uThread = getThreadIndex();
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    state.m_threadNames[uThread] = sName;
+}
+
+void Trace::addZone(const char* sName, int64_t nStartUs, int64_t nEndUs)
+{
+    getState().add(Event{ eEventZone, sName, getThreadIndex(), nStartUs, nEndUs - nStartUs });
+}
+
+void Trace::spanUntilLanded(const char* sTrack, const FenceTicket& ticket)
+{
+    if (!isEnabled())
+        return;
+    int64_t nNowUs = nowUs();
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    int64_t nId = ++state.m_nSpans;
+    sTrack = state.m_tracks.insert(sTrack).first->c_str();
+    state.m_events.push_back(Event{ eEventSpanBegin, sTrack, 0, nNowUs, nId });
+    state.m_pendingSpans.push_back(PendingSpan{ sTrack, ticket, nId });
+}
+
+void Trace::counter(const char* sName, int64_t value)
+{
+    if (!isEnabled())
+        return;
+    getState().add(Event{ eEventCounter, sName, 0, nowUs(), value });
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "IFence.h"
+#include <filesystem>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+// Chrome/Perfetto trace of the process ("traceEvents" JSON, open it in ui.perfetto.dev or chrome://tracing).
+// everything is compiled in; while tracing is off every entry point costs one relaxed atomic load
+class Trace
+{
+public:
+    static inline bool isEnabled() { return s_bEnabled.load(std::memory_order_relaxed); }
+
+    static void start();
+    // stops tracing and writes the events recorded since start()
+    static bool stop(const std::filesystem::path& sPath);
+
+    // name of the calling thread in the trace
+    static void setThreadName(const char* sName);
+
+    // CPU zone on the calling thread, from construction to destruction. sName must outlive the trace
+    class Zone
+    {
+    public:
+        inline explicit Zone(const char* sName)
+        {
+            if (isEnabled())
+            {
+                m_sName = sName;
+                m_nStartUs = nowUs();
+            }
+        }
+        inline ~Zone()
+        {
+            if (m_sName)
+            {
+                addZone(m_sName, m_nStartUs, nowUs());
+            }
+        }
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* m_sName = nullptr;
+        int64_t m_nStartUs = 0;
+    };
+
+    // async span on the track sTrack that ends once the ticket lands (sampled with IFence::getLastLandedValue()).
+    // sTrack is copied
+    static void spanUntilLanded(const char* sTrack, const FenceTicket& ticket);
+    static void counter(const char* sName, int64_t value);
+
+private:
+    static int64_t nowUs();
+    static void addZone(const char* sName, int64_t nStartUs, int64_t nEndUs);
+
+    static std::atomic<bool> s_bEnabled;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+// Trace::Zone for the rest of the enclosing scope
+#define TRACE_ZONE(sName) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(sName)
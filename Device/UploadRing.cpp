@@ -0,0 +1,160 @@
+#include "framework.h"
+#include "UploadRing.h"
+#include "IQueue.hpp"
+#include "IResource.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+    std::shared_ptr<IResource> createStagingBuffer(IDevice* pDevice, uint64_t nBytes)
+    {
+        assert(nBytes <= UINT32_MAX && "Staging buffer is too large");
+        IResource::ResDesc desc;
+        desc.m_format = IResource::eFormatUnknown;
+        desc.m_nDims = 1;
+        desc.m_res[0] = uint32_t(nBytes);
+        desc.m_res[1] = 1;
+        desc.m_res[2] = 1;
+        desc.m_isStaging = true;
+        desc.m_isPersistentlyMapped = true;
+        return pDevice->createResource(desc);
+    }
+
+    uint64_t alignUp(uint64_t value, uint64_t nAlignment)
+    {
+        return (value + nAlignment - 1) / nAlignment * nAlignment;
+    }
+}
+
+UploadRing::UploadRing(IQueue* pQueue, uint64_t nBytes)
+    : m_pQueue(pQueue)
+    , m_nSize(nBytes)
+{
+    m_pBuffer = createStagingBuffer(pQueue->getDevice(), nBytes);
+    assert(m_pBuffer && "Failed to create upload ring buffer");
+#ifndef NDEBUG
+    m_pBuffer->setName(L"UploadRing");
+#endif
+    m_pData = static_cast<uint8_t*>(m_pBuffer->map());
+    assert(m_pData && "Failed to map upload ring buffer");
+}
+
+UploadRing::~UploadRing()
+{
+    // the memory may still be read by executed copies
+    uint64_t lastValue = 0;
+    for (auto& block : m_blocks)
+    {
+        if (block.m_fenceValue != s_nNotExecuted)
+            lastValue = std::max(lastValue, block.m_fenceValue);
+    }
+    m_pQueue->getFence()->waitCpuFence(lastValue);
+    // the buffer stays mapped until it is released
+}
+
+UploadRing::Allocation UploadRing::allocate(ICmdList* pCmdList, uint64_t nBytes, uint64_t nAlignment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (nBytes > m_nSize)
+    {
+        return allocateDedicated(pCmdList, nBytes);
+    }
+
+    // allocations never straddle the end of the buffer - skip to the beginning instead
+    uint64_t nPos = m_nHead % m_nSize;
+    uint64_t nPadding = alignUp(nPos, nAlignment) - nPos;
+    if (nPos + nPadding + nBytes > m_nSize)
+    {
+        nPadding = m_nSize - nPos;
+    }
+    uint64_t nNewHead = m_nHead + nPadding + nBytes;
+
+    while (nNewHead - m_nTail > m_nSize)
+    {
+        if (!reclaimOldest())
+        {
+            // the ring is full of allocations of lists that are still recorded
+            return allocateDedicated(pCmdList, nBytes);
+        }
+    }
+
+    // the newest block grows while the same list allocates
+    auto& blocks = pCmdList->getStagingBlocks();
+    if (!m_blocks.empty() && !blocks.empty() && blocks.back() == m_nFirstBlock + m_blocks.size() - 1)
+    {
+        m_blocks.back().m_nEnd = nNewHead;
+    }
+    else
+    {
+        Block block;
+        block.m_nEnd = nNewHead;
+        m_blocks.push_back(block);
+        blocks.push_back(m_nFirstBlock + m_blocks.size() - 1);
+    }
+    pCmdList->setUploadRing(this);
+
+    Allocation allocation;
+    allocation.m_pBuffer = m_pBuffer.get();
+    allocation.m_nOffset = (m_nHead + nPadding) % m_nSize;
+    allocation.m_pData = m_pData + allocation.m_nOffset;
+    m_nHead = nNewHead;
+    return allocation;
+}
+
+void UploadRing::onExecuted(ICmdList& cmdList, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& pBuffer : cmdList.getStagingBuffers())
+    {
+        m_pQueue->getDevice()->retire(std::move(pBuffer), FenceTicket{ m_pQueue->getFence(), fenceValue });
+    }
+    cmdList.getStagingBuffers().clear();
+
+    for (uint64_t uBlock : cmdList.getStagingBlocks())
+    {
+        m_blocks[size_t(uBlock - m_nFirstBlock)].m_fenceValue = fenceValue;
+    }
+    cmdList.getStagingBlocks().clear();
+}
+
+void UploadRing::release(ICmdList& cmdList)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // the copies were never executed
+    cmdList.getStagingBuffers().clear();
+    for (uint64_t uBlock : cmdList.getStagingBlocks())
+    {
+        m_blocks[size_t(uBlock - m_nFirstBlock)].m_fenceValue = 0;
+    }
+    cmdList.getStagingBlocks().clear();
+}
+
+bool UploadRing::reclaimOldest()
+{
+    // the blocks are released in ring order - a list that is still recorded holds back the blocks after its own
+    if (m_blocks.empty() || m_blocks.front().m_fenceValue == s_nNotExecuted)
+        return false;
+
+    auto& oldest = m_blocks.front();
+    m_pQueue->getFence()->waitCpuFence(oldest.m_fenceValue);
+    m_nTail = oldest.m_nEnd;
+    m_blocks.pop_front();
+    ++m_nFirstBlock;
+    return true;
+}
+
+UploadRing::Allocation UploadRing::allocateDedicated(ICmdList* pCmdList, uint64_t nBytes)
+{
+    auto pBuffer = createStagingBuffer(m_pQueue->getDevice(), nBytes);
+    assert(pBuffer && "Failed to create dedicated staging buffer");
+
+    Allocation allocation;
+    allocation.m_pBuffer = pBuffer.get();
+    allocation.m_pData = static_cast<uint8_t*>(pBuffer->map());
+    pCmdList->getStagingBuffers().push_back(std::move(pBuffer));
+    pCmdList->setUploadRing(this);
+    return allocation;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+struct IQueue;
+struct IResource;
+struct ICmdList;
+
+// persistently mapped staging buffer of a queue. allocations are linear and belong to the command list that
+// reads them - they are reclaimed once the queue's fence reaches the value of the execution of that list, so
+// uploads in steady state neither create resources nor map/unmap anything
+class UploadRing
+{
+public:
+    // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - required for the source of texture copies
+    static constexpr uint64_t s_nTextureAlignment = 512;
+    // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - required for the row pitch of texture copy sources
+    static constexpr uint32_t s_nRowPitchAlignment = 256;
+    static constexpr uint64_t s_nDefaultSize = 64 * 1024 * 1024;
+
+    struct Allocation
+    {
+        IResource* m_pBuffer = nullptr;
+        uint64_t m_nOffset = 0;
+        uint8_t* m_pData = nullptr;
+    };
+
+    UploadRing(IQueue* pQueue, uint64_t nBytes);
+    ~UploadRing();
+
+    // the allocation is read by pCmdList, which is executed on the queue that owns the ring
+    Allocation allocate(ICmdList* pCmdList, uint64_t nBytes, uint64_t nAlignment = s_nTextureAlignment);
+
+    // called by the queue for every executed command list: the memory the list reads is released once the
+    // queue's fence reaches fenceValue
+    void onExecuted(ICmdList& cmdList, uint64_t fenceValue);
+    // releases the memory of a list that was dropped without being executed
+    void release(ICmdList& cmdList);
+
+private:
+    static constexpr uint64_t s_nNotExecuted = UINT64_MAX;
+    // consecutive allocations of one command list
+    struct Block
+    {
+        // ring position the block ends at - it starts where the previous one ends
+        uint64_t m_nEnd = 0;
+        // the memory is released once the queue's fence reaches this value
+        uint64_t m_fenceValue = s_nNotExecuted;
+    };
+    // waits for the oldest block and releases its memory. false if the list of the oldest block was not executed yet
+    bool reclaimOldest();
+    Allocation allocateDedicated(ICmdList* pCmdList, uint64_t nBytes);
+
+    IQueue* m_pQueue = nullptr;
+    std::shared_ptr<IResource> m_pBuffer;
+    uint8_t* m_pData = nullptr;
+    uint64_t m_nSize = 0;
+
+    std::mutex m_mutex;
+    // m_nHead and m_nTail grow monotonously, the position in the buffer is (value % m_nSize)
+    uint64_t m_nHead = 0, m_nTail = 0;
+    // blocks in ring order, m_blocks[i] has the id (m_nFirstBlock + i)
+    std::deque<Block> m_blocks;
+    uint64_t m_nFirstBlock = 0;
+};
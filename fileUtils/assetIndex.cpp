@@ -0,0 +1,141 @@
+#include "pch.h"
+#include <algorithm>
+#include <cctype>
+#include <system_error>
+#include "assetIndex.h"
+#include "fileUtils.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+AssetIndex::~AssetIndex()
+{
+    closeWatch();
+}
+
+bool AssetIndex::open(const std::string& sFolderName, bool bWatch)
+{
+    closeWatch();
+    m_entries.clear();
+    m_bWatch = bWatch;
+    if (!FileUtils::findTheFileOrFolder(sFolderName, m_sRoot))
+    {
+        m_sRoot.clear();
+        return false;
+    }
+    rescan();
+    return true;
+}
+
+const AssetIndex::Entry* AssetIndex::find(const std::string& sName)
+{
+    if (pollChanges())
+    {
+        rescan();
+    }
+    auto it = m_entries.find(makeKey(sName));
+    return it != m_entries.end() ? &it->second : nullptr;
+}
+
+void AssetIndex::rescan()
+{
+    m_entries.clear();
+    if (m_sRoot.empty())
+        return;
+
+#ifdef __linux__
+    // inotify is not recursive - every folder gets its own watch. the instance is recreated so that folders
+    // that are gone drop their watches
+    closeWatch();
+    constexpr uint32_t s_nWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF;
+    if (m_bWatch)
+    {
+        m_nNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_nNotifyFd >= 0)
+            inotify_add_watch(m_nNotifyFd, m_sRoot.string().c_str(), s_nWatchMask);
+    }
+#elif defined(_WIN32)
+    // one notification covers the whole tree - it stays open across rescans
+    if (m_bWatch && !m_hChange)
+    {
+        HANDLE hChange = FindFirstChangeNotificationW(m_sRoot.c_str(), TRUE, FILE_NOTIFY_CHANGE_FILE_NAME |
+            FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+        if (hChange != INVALID_HANDLE_VALUE)
+            m_hChange = hChange;
+    }
+#endif
+
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(m_sRoot, ec), end; !ec && it != end; it.increment(ec))
+    {
+        const auto& entry = *it;
+        if (entry.is_directory(ec))
+        {
+#ifdef __linux__
+            if (m_nNotifyFd >= 0)
+                inotify_add_watch(m_nNotifyFd, entry.path().string().c_str(), s_nWatchMask);
+#endif
+            continue;
+        }
+        if (!entry.is_regular_file(ec))
+            continue;
+        Entry& indexed = m_entries[makeKey(entry.path().lexically_relative(m_sRoot))];
+        indexed.m_sPath = entry.path();
+        indexed.m_nSize = entry.file_size(ec);
+        indexed.m_mtime = entry.last_write_time(ec);
+    }
+}
+
+std::string AssetIndex::makeKey(const std::filesystem::path& sName)
+{
+    std::string sKey = sName.lexically_normal().generic_string();
+#ifdef _WIN32
+    // the file system is case-insensitive
+    std::transform(sKey.begin(), sKey.end(), sKey.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+#endif
+    return sKey;
+}
+
+bool AssetIndex::pollChanges()
+{
+#ifdef __linux__
+    if (m_nNotifyFd < 0)
+        return false;
+    // the events themselves don't matter, any of them invalidates the index
+    bool bChanged = false;
+    alignas(inotify_event) char buffer[4096];
+    while (read(m_nNotifyFd, buffer, sizeof(buffer)) > 0)
+    {
+        bChanged = true;
+    }
+    return bChanged;
+#elif defined(_WIN32)
+    if (!m_hChange)
+        return false;
+    // signalled once for any number of changes - re-armed before the folder is enumerated again
+    if (WaitForSingleObject(m_hChange, 0) != WAIT_OBJECT_0)
+        return false;
+    FindNextChangeNotification(m_hChange);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AssetIndex::closeWatch()
+{
+#ifdef __linux__
+    if (m_nNotifyFd >= 0)
+    {
+        close(m_nNotifyFd);
+        m_nNotifyFd = -1;
+    }
+#elif defined(_WIN32)
+    if (m_hChange)
+    {
+        FindCloseChangeNotification(m_hChange);
+        m_hChange = nullptr;
+    }
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+// index of the files under an asset folder (e.g. "media"). the folder is found once with
+// FileUtils::findTheFileOrFolder() and enumerated into a hash map, so lookups touch no file system.
+// with bWatch, changes under the folder (inotify on Linux, a change notification on Windows) make the next
+// lookup enumerate it again - elsewhere the index only changes on rescan(). lookups are made from one thread
+class AssetIndex
+{
+public:
+    struct Entry
+    {
+        std::filesystem::path m_sPath;
+        uint64_t m_nSize = 0;
+        std::filesystem::file_time_type m_mtime;
+    };
+
+    AssetIndex() = default;
+    ~AssetIndex();
+    AssetIndex(const AssetIndex&) = delete;
+    AssetIndex& operator=(const AssetIndex&) = delete;
+
+    // false if the folder is not found
+    bool open(const std::string& sFolderName, bool bWatch = false);
+    // sName is relative to the folder, e.g. "1.jpg" or "sub/1.jpg". nullptr if there is no such file. the entry
+    // is valid until the next lookup or rescan()
+    const Entry* find(const std::string& sName);
+    inline bool find(const std::string& sName, std::filesystem::path& path)
+    {
+        const Entry* pEntry = find(sName);
+        if (pEntry)
+            path = pEntry->m_sPath;
+        return pEntry != nullptr;
+    }
+    // enumerates the folder again
+    void rescan();
+
+    const std::filesystem::path& getRoot() const { return m_sRoot; }
+    size_t getNumFiles() const { return m_entries.size(); }
+
+private:
+    static std::string makeKey(const std::filesystem::path& sName);
+    // true if the watched folder changed since the last call
+    bool pollChanges();
+    void closeWatch();
+
+    std::filesystem::path m_sRoot;
+    std::unordered_map<std::string, Entry> m_entries;
+    bool m_bWatch = false;
+    // inotify instance watching the folder and its subfolders
+    int m_nNotifyFd = -1;
+    // change notification of the folder tree on Windows
+    void* m_hChange = nullptr;
+};
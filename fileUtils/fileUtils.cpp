@@ -6,15 +6,28 @@
 #include "framework.h"
 #include "fileUtils.h"
 
-bool FileUtils::findTheFileOrFolder(const std::string &sName, std::filesystem::path& _path)
+std::filesystem::path FileUtils::getModuleFolder()
 {
+#ifdef _WIN32
     std::wstring buffer;
     buffer.resize(1024);
-    GetModuleFileNameW(nullptr, &buffer[0], (DWORD)buffer.size());
-
+    buffer.resize(GetModuleFileNameW(nullptr, &buffer[0], (DWORD)buffer.size()));
     std::filesystem::path path = buffer;
-
+#else
+    std::error_code ec;
+    std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (ec)
+    {
+        return std::filesystem::current_path(ec);
+    }
+#endif
     path.remove_filename();
+    return path;
+}
+
+bool FileUtils::findTheFileOrFolder(const std::string &sName, std::filesystem::path& _path)
+{
+    std::filesystem::path path = getModuleFolder();
 
     // go up the tree and find the folder
     for ( ; ; )
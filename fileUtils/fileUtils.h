@@ -6,5 +6,9 @@
 
 struct FileUtils
 {
+    // folder of the running executable
+    static std::filesystem::path getModuleFolder();
+    // looks for sName in the folder of the executable and the folders above it. every call walks the tree -
+    // repeated lookups under one folder go through AssetIndex
     static bool findTheFileOrFolder(const std::string &sName, std::filesystem::path &path);
 };
@@ -7,9 +7,11 @@
 #ifndef PCH_H
 #define PCH_H
 
+#ifdef _WIN32
 #define NOMINMAX
 
 #include <windows.h>
+#endif
 // add headers that you want to pre-compile here
 #include "framework.h"
 
@@ -0,0 +1,149 @@
+#include "FrameTimeline.h"
+#include "Device/FrameStats.h"
+#include <algorithm>
+#include <cstdio>
+
+const char* FrameTimeline::getPhaseName(ePhase ePhase)
+{
+    switch (ePhase)
+    {
+    case ePhasePollEvents: return "pollEvents";
+    case ePhaseGetNextImage: return "getNextImage";
+    case ePhaseCreateResources: return "createResources";
+    case ePhaseLoad: return "load";
+    case ePhaseRecord: return "record";
+    case ePhaseExecute: return "execute";
+    case ePhasePresent: return "present";
+    default: return "unknown";
+    }
+}
+
+FrameTimeline::FrameTimeline(uint32_t nCapacity)
+    : m_start(std::chrono::steady_clock::now())
+{
+    uint64_t nSize = 1;
+    while (nSize < nCapacity)
+    {
+        nSize *= 2;
+    }
+    m_ring.resize(nSize);
+    m_nMask = nSize - 1;
+}
+
+void FrameTimeline::beginFrame(uint32_t uFrame)
+{
+    m_frameStart = m_lastMark = std::chrono::steady_clock::now();
+    m_current = Frame();
+    m_current.m_uFrame = uFrame;
+    m_current.m_fStartMs = std::chrono::duration<double, std::milli>(m_frameStart - m_start).count();
+}
+
+void FrameTimeline::mark(ePhase ePhase)
+{
+    auto now = std::chrono::steady_clock::now();
+    m_current.m_phaseMs[ePhase] += FrameStats::toMs(now - m_lastMark);
+    m_lastMark = now;
+}
+
+void FrameTimeline::endFrame()
+{
+    m_current.m_frameMs = FrameStats::toMs(std::chrono::steady_clock::now() - m_frameStart);
+    uint64_t nWritten = m_nWritten.load(std::memory_order_relaxed);
+    m_ring[nWritten & m_nMask] = m_current;
+    m_nWritten.store(nWritten + 1, std::memory_order_release);
+}
+
+std::vector<FrameTimeline::Frame> FrameTimeline::getFrames() const
+{
+    uint64_t nEnd = m_nWritten.load(std::memory_order_acquire);
+    uint64_t nBegin = nEnd > m_ring.size() ? nEnd - m_ring.size() : 0;
+    std::vector<Frame> frames;
+    frames.reserve(size_t(nEnd - nBegin));
+    for (uint64_t u = nBegin; u < nEnd; ++u)
+    {
+        frames.push_back(m_ring[u & m_nMask]);
+    }
+
+    // the writer may have lapped the copy - drop the frames it overwrote, including the one it may be writing
+    // right now (frame nNewEnd, which is not published yet)
+    uint64_t nNewEnd = m_nWritten.load(std::memory_order_acquire);
+    if (nNewEnd + 1 > nBegin + m_ring.size())
+    {
+        size_t nOverwritten = size_t(std::min<uint64_t>(nNewEnd + 1 - m_ring.size() - nBegin, frames.size()));
+        frames.erase(frames.begin(), frames.begin() + nOverwritten);
+    }
+    return frames;
+}
+
+bool FrameTimeline::exportCsv(const std::filesystem::path& sPath) const
+{
+    FILE* fp = fopen(sPath.string().c_str(), "w");
+    if (!fp)
+        return false;
+    fprintf(fp, "frame,startMs,frameMs");
+    for (uint32_t uPhase = 0; uPhase < ePhaseCount; ++uPhase)
+    {
+        fprintf(fp, ",%sMs", getPhaseName(ePhase(uPhase)));
+    }
+    fprintf(fp, "\n");
+    for (auto& frame : getFrames())
+    {
+        fprintf(fp, "%u,%.3f,%.3f", frame.m_uFrame, frame.m_fStartMs, frame.m_frameMs);
+        for (float fMs : frame.m_phaseMs)
+        {
+            fprintf(fp, ",%.3f", fMs);
+        }
+        fprintf(fp, "\n");
+    }
+    return fclose(fp) == 0;
+}
+
+bool FrameTimeline::exportJson(const std::filesystem::path& sPath) const
+{
+    FILE* fp = fopen(sPath.string().c_str(), "w");
+    if (!fp)
+        return false;
+    auto frames = getFrames();
+
+    // the frame time first, then the phases
+    auto writeStats = [&](const char* sName, const std::vector<float>& samples, bool bLast)
+    {
+        std::vector<uint32_t> histogram(s_nHistogramBuckets, 0);
+        for (float fMs : samples)
+        {
+            uint32_t uBucket = uint32_t(std::max(fMs, 0.0f) / s_fHistogramBucketMs);
+            ++histogram[std::min(uBucket, s_nHistogramBuckets - 1)];
+        }
+        fprintf(fp, "    \"%s\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"histogram\": [",
+            sName, FrameStats::getPercentile(samples, 50), FrameStats::getPercentile(samples, 90), FrameStats::getPercentile(samples, 99),
+            FrameStats::getPercentile(samples, 100));
+        for (uint32_t u = 0; u < s_nHistogramBuckets; ++u)
+        {
+            fprintf(fp, u ? ", %u" : "%u", histogram[u]);
+        }
+        fprintf(fp, "] }%s\n", bLast ? "" : ",");
+    };
+
+    fprintf(fp, "{\n  \"frameCount\": %zu,\n  \"histogramBucketMs\": %.3f,\n  \"stats\": {\n", frames.size(), s_fHistogramBucketMs);
+    std::vector<float> samples(frames.size());
+    std::transform(frames.begin(), frames.end(), samples.begin(), [](const Frame& f) { return f.m_frameMs; });
+    writeStats("frame", samples, false);
+    for (uint32_t uPhase = 0; uPhase < ePhaseCount; ++uPhase)
+    {
+        std::transform(frames.begin(), frames.end(), samples.begin(), [uPhase](const Frame& f) { return f.m_phaseMs[uPhase]; });
+        writeStats(getPhaseName(ePhase(uPhase)), samples, uPhase + 1 == ePhaseCount);
+    }
+    fprintf(fp, "  },\n  \"frames\": [\n");
+    for (size_t u = 0; u < frames.size(); ++u)
+    {
+        const Frame& frame = frames[u];
+        fprintf(fp, "    { \"frame\": %u, \"startMs\": %.3f, \"frameMs\": %.3f", frame.m_uFrame, frame.m_fStartMs, frame.m_frameMs);
+        for (uint32_t uPhase = 0; uPhase < ePhaseCount; ++uPhase)
+        {
+            fprintf(fp, ", \"%s\": %.3f", getPhaseName(ePhase(uPhase)), frame.m_phaseMs[uPhase]);
+        }
+        fprintf(fp, " }%s\n", u + 1 == frames.size() ? "" : ",");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return fclose(fp) == 0;
+}
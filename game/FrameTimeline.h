@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// CPU timeline of the main loop: every frame is split into phases, the time between two mark() calls is
+// added to the phase passed to the second one. the last nCapacity frames are kept in a ring that the
+// loop writes without locking - a reader copies it and drops the frames that got overwritten meanwhile (and the
+// oldest one of a full ring, which the next frame is written over)
+class FrameTimeline
+{
+public:
+    enum ePhase
+    {
+        ePhasePollEvents,
+        ePhaseGetNextImage,
+        ePhaseCreateResources,
+        ePhaseLoad,
+        ePhaseRecord,
+        ePhaseExecute,
+        ePhasePresent,
+        ePhaseCount
+    };
+    static const char* getPhaseName(ePhase ePhase);
+
+    struct Frame
+    {
+        uint32_t m_uFrame = 0;
+        // since the construction of the timeline
+        double m_fStartMs = 0;
+        float m_phaseMs[ePhaseCount] = {};
+        float m_frameMs = 0;
+    };
+
+    // nCapacity is rounded up to a power of two
+    explicit FrameTimeline(uint32_t nCapacity = 8192);
+
+    void beginFrame(uint32_t uFrame);
+    void mark(ePhase ePhase);
+    void endFrame();
+
+    // frames still in the ring, oldest first
+    std::vector<Frame> getFrames() const;
+
+    // raw frames, one row per frame
+    bool exportCsv(const std::filesystem::path& sPath) const;
+    // percentiles and histograms of the frame time and of every phase, plus the raw frames
+    bool exportJson(const std::filesystem::path& sPath) const;
+
+private:
+    // width and number of the histogram buckets - the last one also counts everything above
+    static constexpr float s_fHistogramBucketMs = 1.0f;
+    static constexpr uint32_t s_nHistogramBuckets = 64;
+
+    std::chrono::steady_clock::time_point m_start, m_frameStart, m_lastMark;
+    Frame m_current;
+
+    std::vector<Frame> m_ring;
+    uint64_t m_nMask = 0;
+    // number of frames written so far, published after the frame is complete
+    std::atomic<uint64_t> m_nWritten = 0;
+};
@@ -1,48 +1,161 @@
 #include "Device/IDevice.h"
 #include "Device/IResource.h"
 #include "Device/IWindow.h"
+#include "Device/HeadlessWindow.h"
+#include "Device/DecodeService.h"
+#include "Device/Trace.h"
+#include "FrameTimeline.h"
 #include "math/vector.h"
-#include "fileUtils/fileUtils.h"
+#include "fileUtils/assetIndex.h"
 #include <memory>
 #include <cstdio>
 #include <filesystem>
 #include <chrono>
 #include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <map>
+#include <string>
 
-static bool areSame(IResource* p1, IResource* p2)
+static bool hasLayout(IResource* p, const IResource::ResDesc& desc)
 {
-    if (p1 == nullptr && p2 == nullptr)
-        return true;
-    if (p1 == nullptr || p2 == nullptr)
+    if (p == nullptr)
         return false;
-    IResource::ResDesc d1, d2;
-    p1->getDesc(d1);
-    p2->getDesc(d2);
-    return d1 == d2;
+    IResource::ResDesc d;
+    p->getDesc(d);
+    return d.isCopyCompatible(desc);
 }
 
-int main()
+static bool findMediaFile(AssetIndex& media, uint32_t uFrame, std::filesystem::path& sPath)
 {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%d.jpg", uFrame + 1);
+    return media.find(buffer, sPath);
+}
+
+int main(int argc, char** argv)
+{
+    // command line:
+    //   --cpu             use software devices instead of the GPUs (always the case without D3D12)
+    //   --headless WxH    present into offscreen images of the given resolution
+    //   --interval MS     simulated vsync interval of the offscreen presentation
+    //   --frames N        exit after N frames
+    //   --timeline PATH   write the CPU timeline of the frames to PATH.csv and PATH.json at exit
+    //   --trace PATH      write a Chrome/Perfetto trace of the run to PATH
+    //   --format F        format of the uploaded frames: rgba8 (default), bc1, bc3 or bc7. the block-compressed
+    //                     ones are decoded by the swap chain copy, which only the software devices can do, and
+    //                     need a resolution that is a multiple of 4
+    bool bUseCpuDevice = false, bHeadless = false;
+    uint2 vHeadlessRes(1920, 1080);
+    double fPresentIntervalMs = 0;
+    uint32_t nMaxFrames = 0;
+    std::filesystem::path sTimelinePath, sTracePath;
+    IResource::eFormat frameFormat = IResource::eFormatRGBA8;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--cpu") == 0)
+            bUseCpuDevice = true;
+        else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            bHeadless = true;
+            if (sscanf(argv[++i], "%ux%u", &vHeadlessRes.x, &vHeadlessRes.y) != 2)
+            {
+                printf("Invalid resolution: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+            fPresentIntervalMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            nMaxFrames = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--timeline") == 0 && i + 1 < argc)
+            sTimelinePath = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            sTracePath = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            const char* sFormat = argv[++i];
+            if (strcmp(sFormat, "rgba8") == 0)
+                frameFormat = IResource::eFormatRGBA8;
+            else if (strcmp(sFormat, "bc1") == 0)
+                frameFormat = IResource::eFormatBC1;
+            else if (strcmp(sFormat, "bc3") == 0)
+                frameFormat = IResource::eFormatBC3;
+            else if (strcmp(sFormat, "bc7") == 0)
+                frameFormat = IResource::eFormatBC7;
+            else
+            {
+                printf("Invalid format: %s\n", sFormat);
+                return 1;
+            }
+        }
+        else
+        {
+            printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+#ifndef _WIN32
+    bUseCpuDevice = true;
+#endif
+    if (frameFormat != IResource::eFormatRGBA8 && !bUseCpuDevice)
+    {
+        printf("Block-compressed frames need --cpu\n");
+        return 1;
+    }
+    // the slots have the size of the swap chain images and hold whole blocks
+    uint32_t nBlockSize = IResource::getBlockSize(frameFormat);
+    if (vHeadlessRes.x % nBlockSize != 0 || vHeadlessRes.y % nBlockSize != 0)
+    {
+        printf("Block-compressed frames need a resolution that is a multiple of %u: %ux%u\n", nBlockSize, vHeadlessRes.x, vHeadlessRes.y);
+        return 1;
+    }
+    if (!sTracePath.empty())
+    {
+        Trace::setThreadName("main");
+        Trace::start();
+    }
+
     std::shared_ptr<IDevice> pRenderGPU, pPresentGPU;
 
-    pPresentGPU = IDevice::createD3D12Device(true);  // Use integrated GPU for presentation
+    if (bUseCpuDevice)
+    {
+        pPresentGPU = IDevice::createCpuDevice();
+        pRenderGPU = IDevice::createCpuDevice();
+    }
+#ifdef _WIN32
+    else
+    {
+        pPresentGPU = IDevice::createD3D12Device(true);  // Use integrated GPU for presentation
+        pRenderGPU = IDevice::createD3D12Device(false);  // Use discrete GPU for rendering
+    }
+#endif
     if (!pPresentGPU)
     {
         printf("Failed to create Present device\n");
         return 1;
     }
-
-    pRenderGPU = IDevice::createD3D12Device(false);  // Use discrete GPU for rendering
     if (!pRenderGPU)
     {
         printf("Failed to create Render device\n");
         return 1;
     }
 
-    auto pRenderQueue = pRenderGPU->createQueue(L"RenderQueue");
+    // uploads go through a copy queue, so they overlap with the work of the queues that present
+    auto pUploadQueue = pRenderGPU->createQueue(L"UploadQueue", IDevice::eQueueTypeCopy);
 
     uint32_t nSwapChainImages = 4;
-    auto pWindow = pPresentGPU->createWindow(nSwapChainImages);
+    std::shared_ptr<IWindow> pWindow;
+    std::shared_ptr<HeadlessWindow> pHeadlessWindow;
+    if (bHeadless || bUseCpuDevice)
+    {
+        pHeadlessWindow = HeadlessWindow::create(pPresentGPU.get(), nSwapChainImages, vHeadlessRes, fPresentIntervalMs, nMaxFrames);
+        pWindow = pHeadlessWindow;
+    }
+    else
+    {
+        pWindow = pPresentGPU->createWindow(nSwapChainImages);
+    }
     if (!pWindow)
     {
         printf("Failed to create window\n.");
@@ -51,64 +164,211 @@ int main()
 
     auto pSwapChainQueue = pWindow->getQueue();
 
-    std::vector<std::shared_ptr<IResource>> pSrcFramesD(nSwapChainImages);
-    std::vector<std::shared_ptr<IResource>> pSrcFramesI(nSwapChainImages);
+    // frame pipeline nSlots deep: the render device writes frame i into slot (i % nSlots) while the present device
+    // still copies and presents the frames of the other slots
+    const uint32_t nSlots = nSwapChainImages;
+    std::vector<std::shared_ptr<IResource>> pSrcFramesD(nSlots);
+    std::vector<std::shared_ptr<IResource>> pSrcFramesI(nSlots);
+    // swap chain images keep their contents between presents - the image each slot was last copied into only
+    // needs the dirty rects of the slot copied again
+    std::vector<std::weak_ptr<IResource>> pSlotImages(nSlots);
+    // the devices pace each other on their GPU timelines, the value of frame i is (i + 1): pRenderedFence is
+    // signalled once the frame is in its slot, pCopiedFence once the swap chain copy has read it
+    auto pRenderedFence = pRenderGPU->createFence(true);
+    pPresentGPU->createSharedFence(pRenderGPU, pRenderedFence);
+    auto pCopiedFence = pPresentGPU->createFence(true);
+    pRenderGPU->createSharedFence(pPresentGPU, pCopiedFence);
+
+    // the media folder is looked up once, files dropped into it while running are picked up (on Linux and Windows)
+    AssetIndex media;
+    media.open("media", true);
+    // decode (and encode into the frame format) the media off the render thread, nSwapChainImages frames ahead of use
+    DecodeService decoder(0, 2 * nSwapChainImages, frameFormat);
+    for (uint32_t uFrame = 0; uFrame < nSwapChainImages; ++uFrame)
+    {
+        std::filesystem::path sPath;
+        if (findMediaFile(media, uFrame, sPath))
+        {
+            decoder.prefetch(sPath);
+        }
+    }
+
+    // summed device time of the profiling scopes
+    std::map<std::string, double> scopeTimesMs;
+    uint32_t nFramesPresented = 0;
+    FrameTimeline timeline;
+    // rects of the slot that were uploaded since its last swap chain copy
+    std::vector<ibox2> dirtyRects;
 
     for (uint32_t uFrame = 0; ; ++uFrame)
     {
+        TRACE_ZONE("frame");
+        timeline.beginFrame(uFrame);
         if (!pWindow->pollEvents())
             break;
+        if (nMaxFrames && uFrame >= nMaxFrames)
+            break;
+        timeline.mark(FrameTimeline::ePhasePollEvents);
 
         auto pDstFrame = pWindow->getNextImage();
+        timeline.mark(FrameTimeline::ePhaseGetNextImage);
 
         uint32_t uSrcFrame = uFrame % pSrcFramesD.size();
         auto& pSrcFrame = pSrcFramesD[uSrcFrame];
-        if (!areSame(pSrcFrame.get(), pDstFrame.get()))
+        // the slot has the size of the swap chain image and the frame format
+        IResource::ResDesc desc;
+        pDstFrame->getDesc(desc);
+        desc.m_format = frameFormat;
+        if (!hasLayout(pSrcFrame.get(), desc))
         {
-            IResource::ResDesc desc;
             // if presenting and rendering GPUs are not the same - need the sharing flag
             desc.m_isShared = (pPresentGPU->getDesc() != pRenderGPU->getDesc());
-            pDstFrame->getDesc(desc);
-            pSrcFrame = pRenderGPU->createResource(desc);
+
+            // the old frame may still be read by the swap chain copy - recycle it once that copy is done
+            auto& pSwapChainFence = pSwapChainQueue->getFence();
+            pRenderGPU->releaseResource(pSrcFrame, pSwapChainFence, pSwapChainFence->getLastSignalledValue());
+            pSrcFrame = pRenderGPU->createPooledResource(desc);
 #ifndef NDEBUG
             pSrcFrame->setName(L"pSrcFrame");
 #endif
 
-            // load image from file
-            char buffer[32];
-            sprintf_s(buffer, sizeof(buffer), "media/%d.jpg", uFrame + 1);
-            std::filesystem::path sPath;
-            if (FileUtils::findTheFileOrFolder(buffer, sPath))
-            {
-                pSrcFrame->loadFromFile(sPath, pRenderQueue.get());
-            }
-
             // create resource that presenting GPU can access
             auto pSrcFrameI = pPresentGPU->createSharedResource(pRenderGPU, pSrcFrame);
 #ifndef NDEBUG
             pSrcFrameI->setName(L"pSrcFrameI");
 #endif
+            // the swap chain copy may still read the previous shared resource
+            pPresentGPU->retire(std::move(pSrcFramesI[uSrcFrame]), pSwapChainQueue->getLastSubmittedTicket());
             pSrcFramesI[uSrcFrame] = pSrcFrameI;
+            pSlotImages[uSrcFrame].reset();
+            timeline.mark(FrameTimeline::ePhaseCreateResources);
         }
 
         {
-            auto pCmdList = pSwapChainQueue->startRecording();
-            pCmdList->barrier(pDstFrame.get(), eBarrierStateCommon, eBarrierStateCopyDst);
-            pCmdList->copy(pDstFrame.get(), pSrcFramesI[uSrcFrame].get());
-            pCmdList->barrier(pDstFrame.get(), eBarrierStateCopyDst, eBarrierStateCommon);
-            pSwapChainQueue->execute(pCmdList);
+            // upload the decoded image once the swap chain copy of frame (uFrame - nSlots) is done with the slot
+            TRACE_ZONE("load");
+            if (uFrame >= nSlots)
+            {
+                pCopiedFence->waitGpuFence(pUploadQueue.get(), uFrame - nSlots + 1);
+            }
+            std::filesystem::path sPath;
+            if (findMediaFile(media, uFrame, sPath))
+            {
+                if (auto pImage = decoder.acquire(sPath))
+                {
+                    pSrcFrame->loadFromMemoryAsync(pImage->m_pixels.data(), pImage->m_nWidth, pImage->m_nHeight, pUploadQueue.get());
+                }
+            }
+            // signalled even without media, the swap chain copy waits for it either way
+            pRenderedFence->signalGpuFence(pUploadQueue.get(), uFrame + 1);
+            // the image this slot would need next
+            if (findMediaFile(media, uFrame + nSlots, sPath))
+            {
+                decoder.tryPrefetch(sPath);
+            }
+            timeline.mark(FrameTimeline::ePhaseLoad);
         }
 
-        pWindow->present();
-    }
+        {
+            // the frame is uploaded by another device - its queue waits for it, the CPU moves on
+            pRenderedFence->waitGpuFence(pSwapChainQueue.get(), uFrame + 1);
 
-    pRenderQueue->flush();
+            // nothing to copy if the image already holds the slot and nothing was uploaded since
+            bool bFullCopy = pSlotImages[uSrcFrame].lock() != pDstFrame;
+            pSrcFrame->takeDirtyRects(dirtyRects);
+            if (bFullCopy || !dirtyRects.empty())
+            {
+                IResource* pSrcFrameI = pSrcFramesI[uSrcFrame].get();
+                auto pCmdList = pSwapChainQueue->startRecording();
+                pCmdList->beginScope("swapChainCopy");
+                // both transitions go out as one batch right before the copy
+                pCmdList->transition(pDstFrame.get(), eBarrierStateCopyDst);
+                pCmdList->transition(pSrcFrameI, eBarrierStateCopySrc);
+                if (bFullCopy)
+                {
+                    pCmdList->copy(pDstFrame.get(), pSrcFrameI);
+                }
+                else
+                {
+                    for (const ibox2& rect : dirtyRects)
+                    {
+                        pCmdList->copyRegion(pDstFrame.get(), int3(rect.m_mins, 0), pSrcFrameI,
+                            ibox3(int3(rect.m_mins, 0), int3(rect.m_maxs, 0)));
+                    }
+                }
+                pCmdList->transition(pDstFrame.get(), eBarrierStateCommon);
+                pCmdList->transition(pSrcFrameI, eBarrierStateCommon);
+                pCmdList->endScope();
+                timeline.mark(FrameTimeline::ePhaseRecord);
+                pSwapChainQueue->execute(pCmdList);
+            }
+            pSlotImages[uSrcFrame] = pDstFrame;
+            pCopiedFence->signalGpuFence(pSwapChainQueue.get(), uFrame + 1);
+            timeline.mark(FrameTimeline::ePhaseExecute);
+        }
+
+        {
+            TRACE_ZONE("present");
+            pWindow->present();
+        }
+        timeline.mark(FrameTimeline::ePhasePresent);
+        auto& pSwapChainFence = pSwapChainQueue->getFence();
+        Trace::counter("framesInFlight", int64_t(pSwapChainFence->getLastSignalledValue() - pSwapChainFence->getLastLandedValue()));
+
+        // device times of the frames that have completed by now
+        for (auto* pQueue : { pUploadQueue.get(), pSwapChainQueue.get() })
+        {
+            for (auto& [sName, fMs] : pQueue->collectScopeTimes())
+            {
+                scopeTimesMs[sName] += fMs;
+            }
+        }
+        ++nFramesPresented;
+        timeline.endFrame();
+    }
 
     {
         // execute a dummy cmd list to flush for sure
         auto pCmdList = pSwapChainQueue->startRecording();
         pSwapChainQueue->execute(pCmdList);
-        pSwapChainQueue->flush();
+
+        // wait for both devices at once
+        FenceTicket lastTickets[] = { pUploadQueue->getLastSubmittedTicket(), pSwapChainQueue->getLastSubmittedTicket(),
+            { pRenderedFence, pRenderedFence->getLastSignalledValue() }, { pCopiedFence, pCopiedFence->getLastSignalledValue() } };
+        IFence::waitAll(lastTickets);
+    }
+
+    if (pHeadlessWindow)
+    {
+        pHeadlessWindow->printStats();
+    }
+
+    for (auto* pQueue : { pUploadQueue.get(), pSwapChainQueue.get() })
+    {
+        for (auto& [sName, fMs] : pQueue->collectScopeTimes())
+        {
+            scopeTimesMs[sName] += fMs;
+        }
+    }
+    for (auto& [sName, fMs] : scopeTimesMs)
+    {
+        printf("%-16s %.3f ms/frame\n", sName.c_str(), nFramesPresented ? fMs / nFramesPresented : 0.0);
+    }
+
+    if (!sTracePath.empty() && !Trace::stop(sTracePath))
+    {
+        printf("Failed to write the trace to %s\n", sTracePath.string().c_str());
+    }
+
+    if (!sTimelinePath.empty())
+    {
+        std::filesystem::path sCsvPath = sTimelinePath, sJsonPath = sTimelinePath;
+        sCsvPath += ".csv";
+        sJsonPath += ".json";
+        if (!timeline.exportCsv(sCsvPath) || !timeline.exportJson(sJsonPath))
+        {
+            printf("Failed to write the frame timeline to %s\n", sTimelinePath.string().c_str());
+        }
     }
 
     return 0;